@@ -1,5 +1,4 @@
 #include <iostream>
-#include <map>
 #include <thread>
 #include "objects.h"
 #include "elements.h"
@@ -9,14 +8,13 @@
 using namespace std;
 using namespace em;
 
-typedef RealObject<double, 3> Stack;
+typedef RealObject<float, 3> Stack;
 typedef RealObject<double, 3> Volume;
 typedef RealObject<double, 2> Image;
 typedef RealObject<double, 2> Matrix;
 typedef ComplexHalfObject<double, 2> FourierImage;
 typedef ComplexHalfObject<double, 3> FourierVolume;
-typedef std::multimap<Index3d, element::Complex<double> > FourierMultiVolume;
-typedef std::pair<Index3d, element::Complex<double> > IndexComplexPair;
+typedef FourierAccumulator<double, 3> FourierVolumeAccumulator;
 
 void phase_shift(FourierImage& input, double x_shift, double y_shift) {
     
@@ -31,7 +29,7 @@ void phase_shift(FourierImage& input, double x_shift, double y_shift) {
     }
 }
 
-Index3d tranformed_index(const Index3d& input, double psi, double theta, double phi) {
+Matrix rotation_matrix(double psi, double theta, double phi) {
 
     // Values for transformation
     double cpsi = cos(psi);
@@ -45,10 +43,16 @@ Index3d tranformed_index(const Index3d& input, double psi, double theta, double
     Matrix A(Index2d({3,3}), std::vector<double>({cpsi, -1*spsi, 0, spsi, cpsi, 0, 0, 0, 1}));
     Matrix B(Index2d({3,3}), std::vector<double>({cthe, 0, sthe, 0, 1, 0, -1*sthe, 0, cthe}));
     Matrix C(Index2d({3,3}), std::vector<double>({cphi, -1*sphi, 0, sphi, cphi, 0, 0, 0, 1}));
+    
+    return matrix_multiply(A, matrix_multiply(B, C));
+}
+
+Index3d tranformed_index(const Index3d& input, const Matrix& rotation) {
+
     Matrix in(Index2d({1,3}), std::vector<double>({input.at(0)*1.0, input.at(1)*1.0, input.at(2)*1.0}));
     
-    Matrix result = matrix_multiply(in, matrix_multiply(A, matrix_multiply(B, C)));
-    auto result_vec = result.vectorize();
+    Matrix result = matrix_multiply(in, rotation);
+    const auto& result_vec = result.vectorize();
     
     //cout << input << " -> ";
     //for(auto v : result_vec) cout << " " << v;
@@ -64,49 +68,6 @@ Index3d tranformed_index(const Index3d& input, double psi, double theta, double
     return transformed;
 }
 
-element::Complex<double> average_reflections(const std::vector<element::Complex<double>>& current_reflections) {
-    element::Complex<double> avg(0.0, 0.0);
-    for (const auto& c : current_reflections) avg = avg + c;
-    return avg*(1.0/current_reflections.size());
-}
-
-void average_fourier_volume(const FourierMultiVolume& reflections, FourierVolume& volume) {
-
-    bool initialized = false;
-
-    Index3d current_index;
-    std::vector<element::Complex<double> > current_reflections;
-
-    for (const auto& itr : reflections) {
-        // cout << itr.first << itr.second << endl;
-        // Initialize for the start
-        if (!(initialized)) {
-            current_index = itr.first;
-            initialized = true;
-        }
-
-        // Average and insert accumulated spots
-        if (!(current_index == itr.first)) {
-            
-            // cout << current_index << " -> " << average_reflections(current_reflections) <<  endl;
-            
-            if (volume.range().contains(current_index)) volume[current_index] = average_reflections(current_reflections);
-            else std::cerr << "Out of Bounds: Fourier space with size " << volume.range() << " cannot set reflection " << current_index << endl;
-
-            current_reflections.clear();
-        }
-
-        //Accumulate the spots in a list
-        current_reflections.push_back(itr.second);
-        current_index = itr.first;
-
-    }
-
-    //insert the final reflection
-    if (volume.range().contains(current_index)) volume[current_index] = average_reflections(current_reflections);
-    else std::cerr << "Out of Bounds: Fourier space with size " << volume.range() << " cannot set reflection " << current_index << endl;
-}
-
 int main(int argc, char** argv) {
 
     if (argc < 5) {
@@ -114,11 +75,11 @@ int main(int argc, char** argv) {
         exit(1);
     }
     
-    // Reading the stack
+    // Mapping the stack, the particles are read from the file on demand
     cout << "Reading the particles...\n";
     Stack particles;
     PropertiesMap header_values;
-    MRCFile(argv[1]).load(particles, header_values);
+    MRCFile(argv[1]).load_mapped(particles, header_values);
 
     // Calculate properties from input stack
     int num_particles = particles.range().at(2);
@@ -137,7 +98,9 @@ int main(int argc, char** argv) {
     Table par_table = Table::read_table(argv[2], 6, ' ', 'C');
 
     // Gather data for threading
-    int num_threads = 1;
+    //The threads of the transforms are shared out of the thread budget
+    int num_threads = std::min<int>(parallel::ThreadBudget::Instance().threads(), std::max(num_particles, 1));
+    parallel::ConcurrencyScope concurrency(num_threads);
 
     int thread_load = num_particles / num_threads;
     int extra_load = num_particles % num_threads;
@@ -145,12 +108,16 @@ int main(int argc, char** argv) {
     std::cout << "Running on " << num_threads << " threads\n";
     std::cout << "Thread load: " << thread_load << endl;
 
-    // Locks for concurrent processing
     std::vector<std::thread> threads(num_threads);
     std::mutex critical;
 
-    // Fourier Volume to gather data
-    FourierMultiVolume reflections;
+    // Every thread inserts the reflections in its own Fourier volume, 
+    // the volumes are merged once all the particles are inserted
+    Index3d volume_size({columns, rows, max(columns, rows)});
+    std::vector<FourierVolumeAccumulator> accumulators(num_threads);
+    
+    //The particles are only read, the mapped stack is never copied
+    const Stack& stack = particles;
     
     for (int t = 0; t < num_threads; ++t) {
         int begin = t * thread_load;
@@ -158,11 +125,20 @@ int main(int argc, char** argv) {
 
         //Last one has to take the extra load
         if (t == num_threads - 1) end += extra_load;
-        threads[t] = thread(bind([&](int begin, int end) {
+        threads[t] = thread(bind([&](int thread_id, int begin, int end) {
 
+            FourierVolumeAccumulator& accumulator = accumulators[thread_id];
+            accumulator = FourierVolumeAccumulator(volume_size);
+            
             for (int particle = begin; particle < end; ++particle) {
-                Image image = particles.slice(particle);
-                std::cout << "Processing particle: " << particle +1 << endl;
+                //The temporaries of the particle are taken from the arena of the thread
+                ArenaScope arena;
+                auto image = stack.slice(particle);
+                {
+                    critical.lock();
+                    std::cout << "Processing particle: " << particle +1 << endl;
+                    critical.unlock();
+                }
                 
                 std::vector<double> pars = par_table.get_row<double>(particle);
                 double psi = pars.at(1) * M_PI / 180;
@@ -180,42 +156,45 @@ int main(int argc, char** argv) {
                 //phase_shift(fourier_image, x_shift, y_shift);
 
                 // Transform the indices and place in 3D Fourier space
+                const Matrix rotation = rotation_matrix(psi, theta, phi);
+                const Index2d max_index = fourier_image.miller_index_max();
+                const Index2d min_index = fourier_image.miller_index_min();
+                const Index2d logical_range = fourier_image.logical_range();
                 for (const auto& itr : fourier_image) {
+                    if (itr.value().amplitude() <= 0.000001) continue;
+                    
                     Index2d im_idx = itr.index();
-                    Index3d vol_idx = tranformed_index(Index3d{im_idx.at(0), im_idx.at(1), 0}, psi, theta, phi);
+                    Index3d vol_idx = tranformed_index(Index3d{im_idx.at(0), im_idx.at(1), 0}, rotation);
                     
                     //Bring the index to the current Fourier space size using periodic nature
-                    while(vol_idx[0] > fourier_image.miller_index_max()[0]) vol_idx[0] = vol_idx[0] - (fourier_image.logical_range()[0]);
-                    while(vol_idx[0] < fourier_image.miller_index_min()[0]) vol_idx[0] = vol_idx[0] + (fourier_image.logical_range()[0]);
-                    while(vol_idx[1] > fourier_image.miller_index_max()[1]) vol_idx[1] = vol_idx[1] - fourier_image.logical_range()[1];
-                    while(vol_idx[1] < fourier_image.miller_index_min()[1]) vol_idx[1] = vol_idx[1] + fourier_image.logical_range()[1];
+                    while(vol_idx[0] > max_index[0]) vol_idx[0] = vol_idx[0] - logical_range[0];
+                    while(vol_idx[0] < min_index[0]) vol_idx[0] = vol_idx[0] + logical_range[0];
+                    while(vol_idx[1] > max_index[1]) vol_idx[1] = vol_idx[1] - logical_range[1];
+                    while(vol_idx[1] < min_index[1]) vol_idx[1] = vol_idx[1] + logical_range[1];
                     
-                    auto current_complex = itr.value();
-                    if (vol_idx.at(0) < 0) {
-                        vol_idx = vol_idx * (-1);
-                        current_complex.set_phase(current_complex.phase() * (-1));
-                    }
-
-                    // Synchronously write to the 3D multi reflections volume
-                    critical.lock();
-                    if (itr.value().amplitude() > 0.000001) reflections.insert(IndexComplexPair(vol_idx, current_complex));
-                    critical.unlock();
+                    // Negative h are inserted as their Friedel mates
+                    accumulator.insert(vol_idx, itr.value());
                 }
             }
 
 
-        }, begin, end));
+        }, t, begin, end));
     }
 
     for (thread& t : threads) t.join();
 
     //Compute the final Fourier volume
-    std::cout << "Total number of reflections found in 3D Fourier space: " << reflections.size() << endl;
-    Index3d volume_size({columns, rows, max(columns, rows)});
-    Index3d origin = volume_size*0.5;
-    origin[0] = 0;
-    FourierVolume final_fourier = FourierVolume(volume_size, origin);
-    average_fourier_volume(reflections, final_fourier);
+    FourierVolumeAccumulator& reflections = accumulators[0];
+    for (int t = 1; t < num_threads; ++t) {
+        reflections.merge(accumulators[t]);
+        accumulators[t] = FourierVolumeAccumulator();
+    }
+    if (reflections.rejected() > 0) {
+        std::cerr << "Out of Bounds: Fourier space with size " << volume_size << " could not set " << reflections.rejected() << " reflections\n";
+    }
+    
+    FourierVolume final_fourier;
+    reflections.average(final_fourier);
 
     write("output.hkl", final_fourier);
     
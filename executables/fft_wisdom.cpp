@@ -0,0 +1,84 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sstream>
+
+#include "objects.h"
+#include "elements.h"
+#include "algorithms.h"
+
+using namespace std;
+using namespace em;
+
+/**
+ * Sizes of a box given as "128" (128x128 images), "128x96" or "64x64x64"
+ */
+std::vector<int> box_sizes(const std::string& box) {
+    std::vector<int> sizes;
+    std::stringstream stream(box);
+    std::string size;
+    while (std::getline(stream, size, 'x')) sizes.push_back(stoi(size));
+    if (sizes.size() == 1) sizes.push_back(sizes[0]);
+    return sizes;
+}
+
+template<typename RealType_>
+void plan(const std::vector<int>& sizes, int batch) {
+    fft::FFTWPlanCache& cache = fft::FFTWPlanCache::Instance();
+    std::vector<int> counts = {1};
+    if (batch > 1) counts.push_back(batch);
+    for (int count : counts) {
+        cache.plan<RealType_>(sizes, fft::Direction::FORWARD, fft::FFTEnvironment::Instance().policy(), count);
+        cache.plan<RealType_>(sizes, fft::Direction::INVERSE, fft::FFTEnvironment::Instance().policy(), count);
+    }
+}
+
+int main(int argc, char** argv) {
+
+    if(argc < 3) {
+        std::cerr << "Usage:\n\t" << argv[0] << " [-b <images per batch>] [-t <threads per transform>] [-r estimate|measure|patient] <wisdom file> <box size> [<box size> ...]\n\n";
+        std::cerr << "Measures the FFTW plans of the box sizes (e.g. 128, 128x96 or 64x64x64) and saves them in the wisdom file.\n";
+        std::cerr << "The wisdom file is then used by setting EMKIT_FFTW_WISDOM.\n\n";
+        exit(1);
+    }
+    
+    int arg = 1;
+    int batch = 1;
+    fft::ExecutionPolicy policy = fft::FFTEnvironment::Instance().policy();
+    while (arg + 2 < argc && argv[arg][0] == '-') {
+        std::string option = argv[arg];
+        std::string value = argv[arg + 1];
+        if (option == "-b") batch = stoi(value);
+        else if (option == "-t") policy.threads = stoi(value);
+        else if (option == "-r" && value == "estimate") policy.rigor = fft::PlanningRigor::ESTIMATE;
+        else if (option == "-r" && value == "measure") policy.rigor = fft::PlanningRigor::MEASURE;
+        else if (option == "-r" && value == "patient") policy.rigor = fft::PlanningRigor::PATIENT;
+        else {
+            std::cerr << "Unknown option " << option << " " << value << "\n";
+            exit(1);
+        }
+        arg += 2;
+    }
+    fft::FFTEnvironment::Instance().set_policy(policy);
+    
+    std::string wisdom_file = argv[arg++];
+    auto& environment = fft::FFTEnvironment::Instance();
+    if (environment.set_wisdom_file(wisdom_file)) std::cout << "Loaded the wisdom from " << wisdom_file << "\n";
+    
+    for (; arg < argc; ++arg) {
+        std::vector<int> sizes = box_sizes(argv[arg]);
+        std::cout << "Planning the box " << argv[arg] << " ...\n";
+        plan<double>(sizes, batch);
+#ifdef EM_USE_FFTWF
+        plan<float>(sizes, batch);
+#endif
+    }
+    
+    if (!environment.save_wisdom()) {
+        std::cerr << "Could not write the wisdom to " << wisdom_file << "\n";
+        return 1;
+    }
+    std::cout << "Saved " << fft::FFTWPlanCache::Instance().num_created() << " plans in " << wisdom_file << "\n";
+    
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include <iostream>
+#include <string>
+#include <cmath>
+#include <algorithm>
+
+#include "objects.h"
+#include "elements.h"
+#include "algorithms.h"
+#include "fileio.h"
+
+using namespace std;
+using namespace em;
+using namespace em::element;
+
+typedef RealObject<float, 3> Stack;
+
+/*
+ * Largest difference between the first values in memory of the two
+ * objects, the values of the first object not in the second are ignored
+ */
+float max_difference(const Stack& object, const Stack& reference) {
+    const size_t count = std::min(object.size(), reference.size());
+    float difference = 0;
+    for (size_t id = 0; id < count; ++id) {
+        difference = std::max(difference, std::abs(object.data()[id] - reference.data()[id]));
+    }
+    return difference;
+}
+
+bool check(const string& name, float difference) {
+    cout << "\t" << name << ": " << (difference == 0 ? "OK" : "FAILED") << " (max difference " << difference << ")\n";
+    return difference == 0;
+}
+
+/*
+ * Compares the object mapped from the file with the given access to
+ * the loaded one while reading, writing, resizing and evaluating
+ * expressions referring to the object itself
+ */
+bool check_access(const string& file_name, const Stack& reference, MappedFile::Access access) {
+    PropertiesMap header_values;
+    bool passed = true;
+
+    Stack mapped;
+    MRCFile(file_name).load_mapped(mapped, header_values, access);
+    passed &= check("Read", max_difference(mapped, reference));
+
+    Stack expected = reference;
+    mapped.data()[0] = 1000.0f;
+    expected.data()[0] = 1000.0f;
+    passed &= check("Write", max_difference(mapped, expected));
+
+    Stack resized;
+    MRCFile(file_name).load_mapped(resized, header_values, access);
+    Index3d range = resized.range();
+    range[2] *= 2;
+    resized.resize(range);
+    passed &= check("Resize", max_difference(resized, reference));
+
+    Stack doubled;
+    MRCFile(file_name).load_mapped(doubled, header_values, access);
+    doubled = doubled * 2.0f;
+    doubled += doubled;
+    expected = reference * 4.0f;
+    passed &= check("Self referencing expressions", max_difference(doubled, expected));
+
+    return passed;
+}
+
+int main(int argc, char** argv) {
+
+    if(argc < 2) {
+        std::cerr << "Usage:\n\t" << argv[0] << " <MRC FILE (mode 2)>\n\n";
+        exit(1);
+    }
+
+    Stack reference;
+    PropertiesMap header_values;
+    MRCFile(argv[1]).load(reference, header_values);
+    cout << "Loaded " << argv[1] << " with range: " << reference.range() << "\n";
+
+    bool passed = true;
+    cout << "Mapped read-only:\n";
+    passed &= check_access(argv[1], reference, MappedFile::Access::READ_ONLY);
+    cout << "Mapped copy-on-write:\n";
+    passed &= check_access(argv[1], reference, MappedFile::Access::COPY_ON_WRITE);
+
+    return passed ? 0 : 1;
+
+}
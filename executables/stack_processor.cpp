@@ -2,6 +2,7 @@
 #include <vector>
 #include <thread>
 #include <mutex>
+#include <algorithm>
 #include "objects.h"
 #include "elements.h"
 #include "algorithms.h"
@@ -17,13 +18,14 @@ int main(int argc, char** argv) {
         exit(1);
     }
 
+    typedef RealObject<float, 3> Stack;
     typedef RealObject<double, 3> Volume;
-    typedef RealObject<double, 2> Image;
-    typedef ComplexHalfObject<double, 2> ComplexImage;
+    typedef ComplexHalfObject<double, 3> ComplexStack;
 
-    Volume input;
+    //The stack is mapped from the file and read on demand
+    Stack input;
     PropertiesMap header_values;
-    MRCFile(argv[1]).load(input, header_values);
+    MRCFile(argv[1]).load_mapped(input, header_values);
 
     //Write out the header
     std::cout << "Read " << argv[1] << " with following header fields:\n";
@@ -35,7 +37,9 @@ int main(int argc, char** argv) {
     int rows = input.range().at(1);
 
     //Process the file
-    int num_threads = thread::hardware_concurrency();
+    //The threads of the transforms are shared out of the thread budget
+    int num_threads = std::min<int>(parallel::ThreadBudget::Instance().threads(), std::max(sections, 1));
+    parallel::ConcurrencyScope concurrency(num_threads);
 
     int thread_load = sections / num_threads;
     int extra_load = sections % num_threads;
@@ -46,7 +50,12 @@ int main(int argc, char** argv) {
     std::vector<std::thread> threads(num_threads);
     std::mutex critical;
     Volume output({columns / 2, rows / 2, sections}, 0.0);
-    Index2d output_range = Index2d({columns / 2, rows / 2});
+    Index3d output_range = Index3d({columns / 2, rows / 2, 0});
+    
+    //The images are transformed in batches of consecutive sections
+    const int batch_size = 64;
+    const Stack& stack = input;
+    auto output_view = output.view();
     
     for (int t = 0; t < num_threads; ++t) {
         int begin = t * thread_load;
@@ -57,25 +66,27 @@ int main(int argc, char** argv) {
         //std::cout << "Thread: " << t << " processing " << begin << " to " << end << "\n";
         threads[t] = thread(bind([&](int begin, int end) {
             
-            for (int stack = begin; stack < end; ++stack) {
-                //std::cout << "Processing stack " << stack << std::endl;
-                Image image = input.slice(stack);
-                ComplexImage fourier_image;
+            for (int first = begin; first < end; first += batch_size) {
+                int count = std::min(batch_size, end - first);
+                //The temporaries of the batch are taken from the arena of the thread
+                ArenaScope arena;
+                auto images = stack.view().section(Index3d({0, 0, first}), Index3d({columns, rows, count}));
+                ComplexStack fourier_images;
                 
-                fourier_transform(image, fourier_image, em::fft::FFTEnvironment::Instance().new_transformer());
+                fourier_transform_batch(images, fourier_images, em::fft::FFTEnvironment::Instance().new_transformer());
+                
+                //Crop the images
+                Index3d cropped_range = output_range;
+                cropped_range[2] = count;
+                ComplexStack fourier_cropped(cropped_range);
+                for (auto& data : fourier_images) if (fourier_cropped.range().contains(data.index())) fourier_cropped[data.index()] = data.value();
+
+                //Write to the output directly, sections of different threads do not overlap
+                fourier_transform_batch(fourier_cropped, output_view.section(Index3d({0, 0, first}), cropped_range), em::fft::FFTEnvironment::Instance().new_transformer());
                 
-                //Crop the image
-                ComplexImage fourier_cropped(output_range);
-                for (auto& data : fourier_image) if (fourier_cropped.range().contains(data.index())) fourier_cropped[data.index()] = data.value();
-                Image cropped;
-
-                fourier_transform(fourier_cropped, cropped, em::fft::FFTEnvironment::Instance().new_transformer());
-
-                //Write to the output synchronously
                 {
                     critical.lock();
-                    std::cout << "Setting stack " << stack << std::endl;
-                    output.set_slice(stack, cropped);
+                    for (int section = first; section < first + count; ++section) std::cout << "Setting stack " << section << std::endl;
                     critical.unlock();
                 }
             }
@@ -133,6 +133,15 @@ int main(int argc, char** argv) {
     cout << "Reordered Fourier transformed image:\n" << complex_image_rm << endl; 
     
     
+    /*************************************
+     * Arithmetic
+     *************************************/
+    ImageRM weights({nx, ny}, 0.5);
+    ImageRM averaged = image*0.25 + weights*0.75 - 1.0;
+    averaged *= weights;
+    cout << "Weighted average of the image:\n" << averaged << endl;
+    
+    
     /*************************************
      * Statistics
      *************************************/
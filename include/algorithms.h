@@ -21,8 +21,13 @@
 
 #include "../src/algorithm/convert.hpp"
 #include "../src/algorithm/fourier_transform.hpp"
+#include "../src/algorithm/resolution_map.hpp"
 #include "../src/algorithm/fourier_filter.hpp"
+#include "../src/algorithm/fourier_shell_correlation.hpp"
+#include "../src/algorithm/power_spectrum.hpp"
+#include "../src/algorithm/fourier_accumulator.hpp"
 #include "../src/algorithm/numerics.hpp"
+#include "../src/algorithm/padding.hpp"
 #include "../src/algorithm/matrix_multiplication.hpp"
 
 namespace em {
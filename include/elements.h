@@ -21,12 +21,19 @@
 
 #include "../src/elements/file.hpp"
 #include "../src/elements/binary_file.hpp"
+#include "../src/elements/mapped_file.hpp"
 #include "../src/elements/complex.hpp"
 #include "../src/elements/string.hpp"
 #include "../src/elements/properties_map.hpp"
 #include "../src/elements/index.hpp"
 #include "../src/elements/miller_index.hpp"
+#include "../src/elements/arena.hpp"
+#include "../src/elements/aligned_allocator.hpp"
+#include "../src/elements/tensor_expression.hpp"
+#include "../src/elements/circular_shift.hpp"
+#include "../src/elements/axis_permutation.hpp"
 #include "../src/elements/tensor.hpp"
+#include "../src/elements/tensor_view.hpp"
 #include "../src/elements/tensor_iterator.hpp"
 #include "../src/elements/table.hpp"
 
@@ -21,6 +21,7 @@
 
 #include "elements.h"
 #include "objects.h"
+#include "parallel.h"
 #include "algorithms.h"
 #include "fileio.h"
 
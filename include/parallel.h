@@ -0,0 +1,26 @@
+/* 
+ * This file is a part of emkit.
+ * 
+ * emkit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * emkit is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>
+ * 
+ * Author:
+ * Nikhil Biyani: nikhil(dot)biyani(at)gmail(dot)com
+ * 
+ */
+
+#ifndef EM_PARALLEL_H
+#define EM_PARALLEL_H
+
+#include "../src/parallel/thread_budget.hpp"
+#include "../src/parallel/thread_pool.hpp"
+#include "../src/parallel/parallel_algorithm.hpp"
+
+#endif
@@ -23,12 +23,17 @@
 #include <cassert>
 #include <type_traits>
 
+#include "../elements/circular_shift.hpp"
+#include "../elements/axis_permutation.hpp"
+
 namespace em {
     
     namespace algorithm {
 
         /**
          * Tensor Storage Order Converter
+         * The memory is transposed with the blocked kernel (see 
+         * element::change_storage_order) and shifted if the origins differ.
          * @param input
          * @param output
          */
@@ -39,13 +44,32 @@ namespace em {
 
             assert(input.range() == output.range());
 
-            for (const auto& itr : input) {
-                //auto idx = TensorOutputType_::arranger_type::map(itr.index(), output.range(), output.origin());
-                //std::cout << itr.index() << " -> " << TensorOutputType_::arranger_type::map(idx, output.range(), output.origin()) << std::endl;
-                output[itr.index()] = itr.value();
+            element::change_storage_order<TensorInputType_::storage_order, TensorOutputType_::storage_order>(input.data(), input.range(), output.data());
+            
+            //Move the values to their logical indices in the output
+            if (input.origin() != output.origin()) {
+                element::circular_shift<TensorOutputType_::storage_order>(output.data(), output.range(), output.origin() - input.origin());
             }
 
         }
+        
+        /**
+         * Permutes the axes of a tensor, i.e. the axis i of the output is 
+         * the axis permutation[i] of the input. Used to reorder the volumes
+         * stored with different axes (e.g. MRC files with a non default
+         * mapc/mapr/maps).
+         * @param input
+         * @param permutation
+         * @return tensor with the permuted axes
+         */
+        template<typename TensorType_>
+        TensorType_ permute_axes(const TensorType_& input, const typename TensorType_::index_type& permutation) {
+            assert(element::is_permutation(permutation));
+            
+            TensorType_ output(element::permuted_range(input.range(), permutation), element::permuted_range(input.origin(), permutation));
+            element::permute_axes<TensorType_::storage_order, TensorType_::storage_order>(input.data(), input.range(), output.data(), permutation);
+            return output;
+        }
 
     }
 }
@@ -0,0 +1,178 @@
+/* 
+ * This file is a part of emkit.
+ * 
+ * emkit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * emkit is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>
+ * 
+ * Author:
+ * Nikhil Biyani: nikhil(dot)biyani(at)gmail(dot)com
+ * 
+ */
+
+#ifndef FOURIER_ACCUMULATOR_HPP
+#define FOURIER_ACCUMULATOR_HPP
+
+#include <cstddef>
+#include <cassert>
+
+#include "../elements/complex.hpp"
+#include "../elements/index.hpp"
+#include "../elements/tensor.hpp"
+#include "../elements/tensor_storage_order.hpp"
+#include "../objects/complex_half_object.hpp"
+#include "../parallel/parallel_algorithm.hpp"
+
+namespace em {
+    
+    namespace algorithm {
+        
+        /**
+         * @brief       Accumulates weighted complex values at Miller indices
+         *              of the Hermitian half of a Fourier space, e.g. the 
+         *              central sections of the images inserted in a volume
+         *              by a backprojection.
+         * @description The sums of the values and of the weights are kept
+         *              in dense tensors in the layout of a ComplexHalfObject
+         *              of the logical range (origin at (0, n1/2, n2/2...)).
+         *              An index with a negative h is inserted as its Friedel
+         *              mate with the conjugated value. Indices outside of 
+         *              the half space are rejected and counted.
+         *              
+         *              The insertion is not synchronized: the threads fill
+         *              their own accumulators, which are merged at the end
+         *              (see merge()). Merging in a fixed order gives results
+         *              not depending on the scheduling of the threads.
+         */
+        template<typename ValueType_, size_t rank_>
+        class FourierAccumulator {
+        public:
+            using index_type = element::Index<rank_>;
+            using complex_type = element::Complex<ValueType_>;
+            using object_type = object::ComplexHalfObject<ValueType_, rank_>;
+            
+            FourierAccumulator()
+            : rejected_(0) {
+            }
+            
+            /**
+             * @param logical_range: range of the real space object
+             */
+            explicit FourierAccumulator(const index_type& logical_range)
+            : logical_range_(logical_range), rejected_(0) {
+                index_type range = logical_range;
+                range[0] = range[0] / 2 + 1;
+                index_type origin = range*0.5;
+                origin[0] = 0;
+                sums_ = element::Tensor<complex_type, rank_, element::StorageOrder::COLUMN_MAJOR>(range, origin);
+                weights_ = element::Tensor<ValueType_, rank_, element::StorageOrder::COLUMN_MAJOR>(range, origin);
+                stride_ = element::MemoryArranger<rank_, element::StorageOrder::COLUMN_MAJOR>::get_stride(range);
+            }
+            
+            const index_type& logical_range() const {
+                return logical_range_;
+            }
+            
+            /**
+             * Number of insertions rejected as their index was outside of
+             * the half space
+             */
+            size_t rejected() const {
+                return rejected_;
+            }
+            
+            /**
+             * Adds the value with the weight at the Miller index
+             * @return false if the index is outside of the half space
+             */
+            bool insert(index_type index, complex_type value, ValueType_ weight = 1) {
+                if (index[0] < 0) {
+                    index = index * (-1);
+                    value = complex_type(value.real(), -value.imag());
+                }
+                
+                const index_type& range = sums_.range();
+                const index_type& origin = sums_.origin();
+                size_t id = 0;
+                for (size_t i = 0; i < rank_; ++i) {
+                    const std::ptrdiff_t position = index[i] + origin[i];
+                    if (position < 0 || position >= range[i]) {
+                        ++rejected_;
+                        return false;
+                    }
+                    id += position * stride_[i];
+                }
+                
+                sums_.data()[id] = sums_.data()[id] + value * weight;
+                weights_.data()[id] += weight;
+                return true;
+            }
+            
+            /**
+             * Adds the sums, the weights and the rejections of an 
+             * accumulator of the same range, in parallel over the storage
+             */
+            void merge(const FourierAccumulator& other) {
+                assert(other.logical_range_ == logical_range_);
+                const complex_type* other_sums = other.sums_.data();
+                const ValueType_* other_weights = other.weights_.data();
+                complex_type* sums = sums_.data();
+                ValueType_* weights = weights_.data();
+                parallel::parallel_for(sums_.size(), parallel::block_size<complex_type>(), [&](size_t begin, size_t end) {
+                    for (size_t id = begin; id < end; ++id) {
+                        sums[id] = sums[id] + other_sums[id];
+                        weights[id] += other_weights[id];
+                    }
+                });
+                rejected_ += other.rejected_;
+            }
+            
+            /**
+             * Weighted average of the inserted values, zero where nothing
+             * was inserted
+             */
+            void average(object_type& output) const {
+                object_type result(logical_range_, sums_.origin());
+                const complex_type* sums = sums_.data();
+                const ValueType_* weights = weights_.data();
+                complex_type* values = result.data();
+                parallel::parallel_for(sums_.size(), parallel::block_size<complex_type>(), [&](size_t begin, size_t end) {
+                    for (size_t id = begin; id < end; ++id) {
+                        values[id] = weights[id] != 0 ? sums[id] * (1 / weights[id]) : complex_type();
+                    }
+                });
+                output = std::move(result);
+            }
+            
+            /**
+             * Sums of the values in the layout of the complex half objects
+             */
+            const element::Tensor<complex_type, rank_, element::StorageOrder::COLUMN_MAJOR>& sums() const {
+                return sums_;
+            }
+            
+            /**
+             * Sums of the weights in the layout of the complex half objects
+             */
+            const element::Tensor<ValueType_, rank_, element::StorageOrder::COLUMN_MAJOR>& weights() const {
+                return weights_;
+            }
+            
+        private:
+            index_type logical_range_;
+            index_type stride_;
+            size_t rejected_;
+            element::Tensor<complex_type, rank_, element::StorageOrder::COLUMN_MAJOR> sums_;
+            element::Tensor<ValueType_, rank_, element::StorageOrder::COLUMN_MAJOR> weights_;
+        };
+        
+    }
+}
+
+#endif /* FOURIER_ACCUMULATOR_HPP */
@@ -19,10 +19,20 @@
 #ifndef FOURIER_FILTER_HPP
 #define FOURIER_FILTER_HPP
 
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <algorithm>
 #include <type_traits>
 
+#include "../modules/fft/fft_environment.hpp"
 #include "../objects/object_base_types.hpp"
+#include "../objects/complex_half_object.hpp"
+#include "fourier_transform.hpp"
 #include "resolution_calculator.hpp"
+#include "resolution_map.hpp"
+#include "../parallel/parallel_algorithm.hpp"
 
 namespace em {
     
@@ -49,78 +59,256 @@ namespace em {
             }
         };
         
+        /**
+         * The top hat filters compare the squared resolution of every 
+         * element, read from the shared resolution map of the object, with
+         * the squared cut offs. Both are compared in the single precision of
+         * the map, so that an element on the cut off is always classified
+         * the same way.
+         */
         template<typename ObjectType_>
         struct filtering_impl<ObjectType_, FilterAlgorithm::TOP_HAT> {
             
             static void low_pass(ObjectType_& obj, double cut_off_freq) {
-                for(auto& data : obj) {
-                    if(resolution(data.index(), obj.cell_lengths()) >= cut_off_freq) {
-                        using data_type = typename object::object_traits<ObjectType_>::data_type;
-                        obj[data.index()] = data_type();
-                    }
-                }
+                const float cut_off = squared_cut_off(cut_off_freq);
+                remove_if(obj, [=](float squared) {
+                    return squared >= cut_off;
+                });
             }
             
             static void high_pass(ObjectType_& obj, double cut_off_freq) {
-                for(auto& data : obj) {
-                    if(resolution(data.index(), obj.cell_lengths()) <= cut_off_freq) {
-                        using data_type = typename object::object_traits<ObjectType_>::data_type;
-                        obj[data.index()] = data_type();
-                    }
-                }
+                const float cut_off = squared_cut_off(cut_off_freq);
+                remove_if(obj, [=](float squared) {
+                    return squared <= cut_off;
+                });
             }
             
             static void band_pass(ObjectType_& obj, double low_pass_freq, double high_pass_freq) {
-                for(auto& data : obj) {
-                    if(resolution(data.index(), obj.cell_lengths()) >= low_pass_freq || 
-                       resolution(data.index(), obj.cell_lengths()) <= high_pass_freq) {
-                        using data_type = typename object::object_traits<ObjectType_>::data_type;
-                        obj[data.index()] = data_type();
-                    }
-                }
+                const float low_cut_off = squared_cut_off(low_pass_freq);
+                const float high_cut_off = squared_cut_off(high_pass_freq);
+                remove_if(obj, [=](float squared) {
+                    return squared >= low_cut_off || squared <= high_cut_off;
+                });
             }
             
-        };
-        
-        template<typename ObjectType_>
-        struct filtering_impl<ObjectType_, FilterAlgorithm::BUTTERWORTH> {
-            static void low_pass(ObjectType_& obj, double cut_off_freq) {
-                //TODO
-            }
+        private:
             
-            static void high_pass(ObjectType_& obj, double cut_off_freq) {
-                //TODO
+            static float squared_cut_off(double cut_off_freq) {
+                return (float) (cut_off_freq * cut_off_freq);
             }
             
-            static void band_pass(ObjectType_& obj, double low_pass_freq, double high_pass_freq) {
-                //TODO
+            /**
+             * Sets the elements with a squared resolution matching the 
+             * predicate to zero
+             */
+            template<typename Predicate_>
+            static void remove_if(ObjectType_& obj, const Predicate_& remove) {
+                using data_type = typename object::object_traits<ObjectType_>::data_type;
+                auto map = resolution_map(obj);
+                const float* squared = map->squared_radii().data();
+                data_type* values = obj.data();
+                parallel::parallel_for(obj.size(), parallel::block_size<data_type>(), [&](size_t begin, size_t end) {
+                    for (size_t id = begin; id < end; ++id) {
+                        if (remove(squared[id])) values[id] = data_type();
+                    }
+                });
             }
             
         };
         
-        template<typename ObjectType_>
-        struct filtering_impl<ObjectType_, FilterAlgorithm::GAUSSIAN> {
-            static void low_pass(ObjectType_& obj, double cut_off_freq) {
-                //TODO
+        namespace filter_impl {
+            
+            /**
+             * Order of the Butterworth filters
+             */
+            static const int kButterworthOrder = 4;
+            
+            /**
+             * Number of samples of the radial profiles per resolution shell
+             */
+            static const size_t kProfileSamples = 16;
+            
+            /**
+             * Number of elements processed together, their gains are first
+             * computed in a buffer and the values are then scaled in a 
+             * loop the compiler vectorizes.
+             */
+            static const size_t kChunk = 1024;
+            
+            /**
+             * Transfer functions of the low pass filters for the ratio of
+             * the resolution to the cut off, the high pass filters are 
+             * their complements.
+             */
+            inline double gaussian(double ratio) {
+                return std::exp(-0.5 * ratio * ratio);
             }
             
-            static void high_pass(ObjectType_& obj, double cut_off_freq) {
-                //TODO
+            inline double butterworth(double ratio) {
+                return 1.0 / std::sqrt(1.0 + std::pow(ratio, 2 * kButterworthOrder));
             }
             
-            static void band_pass(ObjectType_& obj, double low_pass_freq, double high_pass_freq) {
-                //TODO
+            /**
+             * @brief       Multiplies every element of the object with the 
+             *              radial transfer function of its resolution.
+             * @description The function is tabulated once on a 1D grid of
+             *              the reciprocal radius, kProfileSamples points per
+             *              shell of the resolution map of the object, and
+             *              interpolated linearly. The elements are scaled in
+             *              a single parallel pass over the storage, the 
+             *              real and imaginary parts being treated as a flat
+             *              array of values.
+             * @param       obj: complex half object
+             * @param       profile: transfer function of the reciprocal radius
+             */
+            template<typename ObjectType_, typename Profile_>
+            void apply_profile(ObjectType_& obj, const Profile_& profile) {
+                using data_type = typename object::object_traits<ObjectType_>::data_type;
+                using value_type = typename data_type::value_type;
+                
+                auto map = resolution_map(obj);
+                const double step = map->shell_width() / kProfileSamples;
+                std::vector<float> table(map->num_shells() * kProfileSamples + 2);
+                for (size_t k = 0; k < table.size(); ++k) table[k] = (float) profile(k * step);
+                
+                const float* squared = map->squared_radii().data();
+                const float* lookup = table.data();
+                const float inverse_step = (float) (1.0 / step);
+                const size_t last = table.size() - 2;
+                value_type* values = reinterpret_cast<value_type*> (obj.data());
+                parallel::parallel_for(obj.size(), std::max(kChunk, parallel::block_size<data_type>()), [&](size_t begin, size_t end) {
+                    float gains[kChunk];
+                    for (size_t first = begin; first < end; first += kChunk) {
+                        const size_t count = std::min(kChunk, end - first);
+                        for (size_t j = 0; j < count; ++j) {
+                            const float position = std::sqrt(squared[first + j]) * inverse_step;
+                            const size_t k = std::min(last, (size_t) position);
+                            const float fraction = position - k;
+                            gains[j] = lookup[k] + fraction * (lookup[k + 1] - lookup[k]);
+                        }
+                        value_type* chunk = values + 2 * first;
+                        for (size_t j = 0; j < count; ++j) {
+                            chunk[2 * j] *= gains[j];
+                            chunk[2 * j + 1] *= gains[j];
+                        }
+                    }
+                });
             }
             
+            /**
+             * Low, high and band pass filters for the transfer function of
+             * a low pass filter. The profiles are functions of the radius
+             * over the cut off, the non-positive cut offs are rejected and
+             * leave the object unchanged.
+             */
+            template<typename ObjectType_, double (*low_pass_profile_)(double)>
+            struct ProfileFilter {
+                static void low_pass(ObjectType_& obj, double cut_off_freq) {
+                    if (!is_positive(cut_off_freq)) return;
+                    apply_profile(obj, [=](double radius) {
+                        return low_pass_profile_(radius / cut_off_freq);
+                    });
+                }
+                
+                static void high_pass(ObjectType_& obj, double cut_off_freq) {
+                    if (!is_positive(cut_off_freq)) return;
+                    apply_profile(obj, [=](double radius) {
+                        return 1.0 - low_pass_profile_(radius / cut_off_freq);
+                    });
+                }
+                
+                static void band_pass(ObjectType_& obj, double low_pass_freq, double high_pass_freq) {
+                    if (!is_positive(low_pass_freq) || !is_positive(high_pass_freq)) return;
+                    apply_profile(obj, [=](double radius) {
+                        return low_pass_profile_(radius / low_pass_freq) * (1.0 - low_pass_profile_(radius / high_pass_freq));
+                    });
+                }
+                
+            private:
+                
+                static bool is_positive(double cut_off_freq) {
+                    if (cut_off_freq > 0) return true;
+                    std::cerr << "ERROR: The cut off frequency of the filter should be positive, got " << cut_off_freq << "\n";
+                    return false;
+                }
+            };
+            
+        }
+        
+        /**
+         * Gaussian filters, exp(-r^2 / (2 c^2)) for the low pass with the 
+         * cut off c.
+         */
+        template<typename ObjectType_>
+        struct filtering_impl<ObjectType_, FilterAlgorithm::GAUSSIAN> : filter_impl::ProfileFilter<ObjectType_, filter_impl::gaussian> {
         };
         
+        /**
+         * Butterworth filters, 1/sqrt(1 + (r/c)^(2n)) for the low pass with 
+         * the cut off c and the order n (see filter_impl::kButterworthOrder).
+         */
         template<typename ObjectType_>
+        struct filtering_impl<ObjectType_, FilterAlgorithm::BUTTERWORTH> : filter_impl::ProfileFilter<ObjectType_, filter_impl::butterworth> {
+        };
+        
+        /**
+         * Removes the resolutions above the cut off frequency of the 
+         * complex half object in place
+         */
+        template<FilterAlgorithm algo_ = FilterAlgorithm::TOP_HAT, typename ObjectType_>
         typename std::enable_if<object::is_complex_valued<typename object::object_traits<ObjectType_>::data_type>::value, void>::type
         low_pass(ObjectType_& obj, double cut_off_freq) {
-            return filtering_impl<ObjectType_, FilterAlgorithm::TOP_HAT>::low_pass(obj, cut_off_freq);
+            return filtering_impl<ObjectType_, algo_>::low_pass(obj, cut_off_freq);
+        }
+        
+        /**
+         * Removes the resolutions below the cut off frequency of the 
+         * complex half object in place
+         */
+        template<FilterAlgorithm algo_ = FilterAlgorithm::TOP_HAT, typename ObjectType_>
+        typename std::enable_if<object::is_complex_valued<typename object::object_traits<ObjectType_>::data_type>::value, void>::type
+        high_pass(ObjectType_& obj, double cut_off_freq) {
+            return filtering_impl<ObjectType_, algo_>::high_pass(obj, cut_off_freq);
         }
         
+        /**
+         * Keeps the resolutions between the high pass and the low pass 
+         * frequencies of the complex half object
+         */
+        template<FilterAlgorithm algo_ = FilterAlgorithm::TOP_HAT, typename ObjectType_>
+        typename std::enable_if<object::is_complex_valued<typename object::object_traits<ObjectType_>::data_type>::value, void>::type
+        band_pass(ObjectType_& obj, double low_pass_freq, double high_pass_freq) {
+            return filtering_impl<ObjectType_, algo_>::band_pass(obj, low_pass_freq, high_pass_freq);
+        }
         
+        /**
+         * @brief       Filters the real object in place through its Fourier
+         *              transform.
+         * @description The object is transformed, band passed and 
+         *              transformed back into its own memory. A non positive
+         *              frequency disables its side of the band, i.e. the 
+         *              filter is a low pass for high_pass_freq <= 0 and a 
+         *              high pass for low_pass_freq <= 0.
+         * @param       real
+         * @param       low_pass_freq: frequency above which the resolutions
+         *              are removed
+         * @param       high_pass_freq: frequency below which the resolutions
+         *              are removed
+         * @param       transformer
+         */
+        template<FilterAlgorithm algo_ = FilterAlgorithm::TOP_HAT, typename ValueType_, size_t rank_>
+        void fourier_filter(object::RealObject<ValueType_, rank_>& real, double low_pass_freq, double high_pass_freq,
+                std::shared_ptr<fft::FFTInterface> transformer = fft::FFTEnvironment::Instance().global_transformer()) {
+            using complex_type = object::ComplexHalfObject<ValueType_, rank_>;
+            if (low_pass_freq <= 0 && high_pass_freq <= 0) return;
+            
+            complex_type complex;
+            fourier_transform(real, complex, transformer);
+            if (high_pass_freq <= 0) filtering_impl<complex_type, algo_>::low_pass(complex, low_pass_freq);
+            else if (low_pass_freq <= 0) filtering_impl<complex_type, algo_>::high_pass(complex, high_pass_freq);
+            else filtering_impl<complex_type, algo_>::band_pass(complex, low_pass_freq, high_pass_freq);
+            fourier_transform(complex, real.view(), transformer);
+        }
         
     }
 }
@@ -0,0 +1,227 @@
+/* 
+ * This file is a part of emkit.
+ * 
+ * emkit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * emkit is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>
+ * 
+ * Author:
+ * Nikhil Biyani: nikhil(dot)biyani(at)gmail(dot)com
+ * 
+ */
+
+#ifndef FOURIER_SHELL_CORRELATION_HPP
+#define FOURIER_SHELL_CORRELATION_HPP
+
+#include <cstddef>
+#include <cassert>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "../elements/complex.hpp"
+#include "../elements/table.hpp"
+#include "../objects/complex_half_object.hpp"
+#include "../parallel/parallel_algorithm.hpp"
+#include "resolution_map.hpp"
+
+namespace em {
+    
+    namespace algorithm {
+        
+        namespace correlation_impl {
+            
+            /**
+             * Sums of the cross products, of the powers of both objects
+             * and of the number of elements in every shell
+             */
+            struct ShellSums {
+                
+                ShellSums(size_t shells = 0)
+                : cross(shells, 0), power1(shells, 0), power2(shells, 0), count(shells, 0) {
+                }
+                
+                ShellSums& operator+=(const ShellSums& other) {
+                    for (size_t shell = 0; shell < cross.size(); ++shell) {
+                        cross[shell] += other.cross[shell];
+                        power1[shell] += other.power1[shell];
+                        power2[shell] += other.power2[shell];
+                        count[shell] += other.count[shell];
+                    }
+                    return *this;
+                }
+                
+                /**
+                 * Normalized correlation of the shell, 0 if any of the 
+                 * powers vanishes
+                 */
+                double correlation(size_t shell) const {
+                    const double norm = std::sqrt(power1[shell] * power2[shell]);
+                    return norm > 0 ? cross[shell] / norm : 0;
+                }
+                
+                std::vector<double> cross;
+                std::vector<double> power1;
+                std::vector<double> power2;
+                std::vector<size_t> count;
+            };
+            
+            /**
+             * Adds the elements [begin, end) of the Hermitian halves to the
+             * sums of their shells. The elements are weighted with their
+             * multiplicity, so that the sums are the ones of the full 
+             * Fourier space. Shells beyond the sums are skipped.
+             */
+            template<typename ValueType_, size_t rank_>
+            void accumulate(const element::Complex<ValueType_>* values1, const element::Complex<ValueType_>* values2,
+                    const ResolutionMap<rank_>& map, size_t begin, size_t end, ShellSums& sums) {
+                const size_t length = map.squared_radii().range()[0];
+                const int* shells = map.shells().data();
+                const size_t num_shells = sums.cross.size();
+                for (size_t id = begin; id < end; ++id) {
+                    const size_t shell = shells[id];
+                    if (shell >= num_shells) continue;
+                    const int weight = map.multiplicity(id % length);
+                    const double real1 = values1[id].real(), imag1 = values1[id].imag();
+                    const double real2 = values2[id].real(), imag2 = values2[id].imag();
+                    sums.cross[shell] += weight * (real1 * real2 + imag1 * imag2);
+                    sums.power1[shell] += weight * (real1 * real1 + imag1 * imag1);
+                    sums.power2[shell] += weight * (real2 * real2 + imag2 * imag2);
+                    sums.count[shell] += weight;
+                }
+            }
+            
+            /**
+             * Sums of two objects sharing the map. The storage is split in
+             * blocks accumulated in parallel, each into its own sums, 
+             * which are added in the order of the blocks at the end.
+             */
+            template<typename ValueType_, size_t rank_>
+            ShellSums shell_sums(const element::Complex<ValueType_>* values1, const element::Complex<ValueType_>* values2,
+                    const ResolutionMap<rank_>& map, size_t shells) {
+                return parallel::parallel_reduce_blocks(map.size(), parallel::block_size<element::Complex<ValueType_>>(), ShellSums(shells),
+                    [&](size_t begin, size_t end) {
+                        ShellSums sums(shells);
+                        accumulate(values1, values2, map, begin, end, sums);
+                        return sums;
+                    },
+                    [](ShellSums total, const ShellSums& partial) {
+                        return total += partial;
+                    });
+            }
+            
+            /**
+             * Row of the table for a shell, prefixed by the given columns
+             */
+            template<size_t rank_>
+            std::vector<std::string> shell_row(std::vector<std::string> row, const ResolutionMap<rank_>& map, const ShellSums& sums, size_t shell) {
+                row.push_back(std::to_string(shell));
+                row.push_back(std::to_string(map.shell_radius(shell)));
+                row.push_back(std::to_string(sums.correlation(shell)));
+                row.push_back(std::to_string(sums.count[shell]));
+                return row;
+            }
+            
+            /**
+             * Correlation of two objects of the same layout in every shell
+             */
+            template<typename ValueType_, size_t rank_>
+            element::Table shell_correlation(const object::ComplexHalfObject<ValueType_, rank_>& object1, 
+                    const object::ComplexHalfObject<ValueType_, rank_>& object2, size_t shells) {
+                assert(object1.logical_range() == object2.logical_range() && object1.origin() == object2.origin());
+                auto map = resolution_map(object1);
+                shells = reported_shells(*map, shells);
+                const ShellSums sums = shell_sums(object1.data(), object2.data(), *map, shells);
+                
+                element::Table table(4);
+                for (size_t shell = 0; shell < shells; ++shell) table.append_row(shell_row({}, *map, sums, shell));
+                return table;
+            }
+            
+        }
+        
+        /**
+         * @brief       Fourier shell correlation of two volumes.
+         * @description The correlation is computed on the Hermitian halves
+         *              of the transforms in a single parallel pass, with 
+         *              the shells of the resolution map of the volumes 
+         *              (one Fourier pixel wide along the longest axis of 
+         *              the cell). The elements are counted with their 
+         *              Friedel mates, as in the full Fourier space.
+         * @param       volume1: transform of the first volume
+         * @param       volume2: transform of the second volume, of the 
+         *              same logical range and origin
+         * @param       shells: number of shells reported, all of them for 0
+         * @return      table with the columns shell, resolution (reciprocal
+         *              radius of the shell), FSC and number of elements
+         */
+        template<typename ValueType_>
+        element::Table fourier_shell_correlation(const object::ComplexHalfObject<ValueType_, 3>& volume1, 
+                const object::ComplexHalfObject<ValueType_, 3>& volume2, size_t shells = 0) {
+            return correlation_impl::shell_correlation(volume1, volume2, shells);
+        }
+        
+        /**
+         * Fourier ring correlation of two images, with the columns ring,
+         * resolution, FRC and number of elements (see 
+         * fourier_shell_correlation).
+         */
+        template<typename ValueType_>
+        element::Table fourier_ring_correlation(const object::ComplexHalfObject<ValueType_, 2>& image1, 
+                const object::ComplexHalfObject<ValueType_, 2>& image2, size_t rings = 0) {
+            return correlation_impl::shell_correlation(image1, image2, rings);
+        }
+        
+        /**
+         * @brief       Fourier ring correlations of the pairs of images of 
+         *              two stacks.
+         * @description The stacks are the batched transforms of the images
+         *              (see fourier_transform_batch), the last axis being 
+         *              the image number. All the images share the ring map
+         *              of the image layout, the pairs are correlated in 
+         *              parallel, each with its own accumulators.
+         * @param       stack1
+         * @param       stack2: of the same logical range
+         * @param       rings: number of rings reported, all of them for 0
+         * @return      table with the columns image, ring, resolution, FRC
+         *              and number of elements, the rings of the first pair
+         *              followed by the ones of the next pairs
+         */
+        template<typename ValueType_>
+        element::Table fourier_ring_correlation_batch(const object::ComplexHalfObject<ValueType_, 3>& stack1, 
+                const object::ComplexHalfObject<ValueType_, 3>& stack2, size_t rings = 0) {
+            assert(stack1.logical_range() == stack2.logical_range());
+            assert(stack1.origin() == stack2.origin());
+            auto map = image_resolution_map(stack1);
+            rings = reported_shells(*map, rings);
+            
+            const size_t images = stack1.logical_range()[2];
+            const size_t image_size = map->size();
+            std::vector<correlation_impl::ShellSums> sums(images);
+            parallel::parallel_for(images, 1, [&](size_t begin, size_t end) {
+                for (size_t image = begin; image < end; ++image) {
+                    sums[image] = correlation_impl::ShellSums(rings);
+                    correlation_impl::accumulate(stack1.data() + image * image_size, stack2.data() + image * image_size, *map, 0, image_size, sums[image]);
+                }
+            });
+            
+            element::Table table(5);
+            for (size_t image = 0; image < images; ++image) {
+                for (size_t ring = 0; ring < rings; ++ring) {
+                    table.append_row(correlation_impl::shell_row({std::to_string(image)}, *map, sums[image], ring));
+                }
+            }
+            return table;
+        }
+        
+    }
+}
+
+#endif /* FOURIER_SHELL_CORRELATION_HPP */
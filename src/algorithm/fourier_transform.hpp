@@ -19,10 +19,15 @@
 #ifndef FOURIER_TRANSFORM_HPP
 #define FOURIER_TRANSFORM_HPP
 
+#include <vector>
+
 #include "../modules/fft/fft_environment.hpp"
 #include "../elements/complex.hpp"
 #include "../elements/tensor.hpp"
+#include "../elements/tensor_view.hpp"
 #include "../elements/tensor_storage_order.hpp"
+#include "../elements/circular_shift.hpp"
+#include "../parallel/parallel_algorithm.hpp"
 #include "../objects/object_base_types.hpp"
 #include "../objects/complex_half_object.hpp"
 
@@ -30,71 +35,312 @@ namespace em {
     
     namespace algorithm {
         
+        namespace fourier_impl {
+            
+            /**
+             * Precision used to transform tensors of the value type. Float
+             * tensors are transformed in single precision, other types in
+             * double precision.
+             */
+            template<typename ValueType_>
+            struct TransformType {
+                using type = double;
+            };
+            
+            template<>
+            struct TransformType<float> {
+                using type = float;
+            };
+            
+            template<typename ValueType_>
+            using AlignedBuffer = std::vector<ValueType_, element::AlignedAllocator<ValueType_>>;
+            
+            /**
+             * Memory of the input values in the precision of the transform.
+             * The memory is used directly if it already has the precision,
+             * otherwise it is converted in the buffer. A Complex<V> is 
+             * stored as two consecutive V values, hence complex tensors are
+             * accessed as arrays of 2*size values.
+             */
+            template<typename TransformType_, typename ValueType_>
+            const TransformType_* input_memory(const ValueType_* data, size_t size, AlignedBuffer<TransformType_>& buffer) {
+                buffer.resize(size);
+                parallel::parallel_for(size, parallel::block_size<TransformType_>(), [&](size_t begin, size_t end) {
+                    for (size_t id = begin; id < end; ++id) buffer[id] = (TransformType_) data[id];
+                });
+                return buffer.data();
+            }
+            
+            template<typename TransformType_>
+            const TransformType_* input_memory(const TransformType_* data, size_t, AlignedBuffer<TransformType_>&) {
+                return data;
+            }
+            
+            /**
+             * Memory receiving the output of the transform, the buffer if
+             * the precision differs from the one of the values (see 
+             * store_output()).
+             */
+            template<typename TransformType_, typename ValueType_>
+            TransformType_* output_memory(ValueType_*, size_t size, AlignedBuffer<TransformType_>& buffer) {
+                buffer.resize(size);
+                return buffer.data();
+            }
+            
+            template<typename TransformType_>
+            TransformType_* output_memory(TransformType_* data, size_t, AlignedBuffer<TransformType_>&) {
+                return data;
+            }
+            
+            /**
+             * Converts the output stored in the buffer by output_memory()
+             * to the values. Nothing is done if the buffer was not used.
+             */
+            template<typename TransformType_, typename ValueType_>
+            void store_output(const AlignedBuffer<TransformType_>& buffer, ValueType_* data) {
+                parallel::parallel_for(buffer.size(), parallel::block_size<TransformType_>(), [&](size_t begin, size_t end) {
+                    for (size_t id = begin; id < end; ++id) data[id] = (ValueType_) buffer[id];
+                });
+            }
+            
+            /**
+             * Sizes of the transform in the order expected by the transformers.
+             * The last axis of a batch is the index of the transforms.
+             */
+            template<size_t rank_>
+            std::vector<int> transform_sizes(const element::Index<rank_>& logical_range, bool batched = false) {
+                std::vector<int> sizes;
+                for (size_t i = 0; i < (batched ? rank_ - 1 : rank_); ++i) sizes.push_back((int) logical_range[i]);
+                return sizes;
+            }
+            
+            /**
+             * Number of transforms of the logical range
+             */
+            template<size_t rank_>
+            size_t transform_count(const element::Index<rank_>& logical_range, bool batched = false) {
+                return batched ? (size_t) logical_range[rank_ - 1] : 1;
+            }
+            
+            /**
+             * Origin of the transforms of the tensor in the order expected by
+             * the transformers. The origin along the last axis of a batch is
+             * the origin of the transform index.
+             */
+            template<size_t rank_>
+            std::vector<int> transform_origin(const element::Index<rank_>& origin, bool batched = false) {
+                std::vector<int> result;
+                for (size_t i = 0; i < (batched ? rank_ - 1 : rank_); ++i) result.push_back((int) origin[i]);
+                return result;
+            }
+            
+            /**
+             * Memory of the tensor with the origin at the lower left corner
+             * as expected by the transformers. Tensors with a different 
+             * origin are shifted into the buffer.
+             */
+            template<typename DataType_, size_t rank_, typename Allocator_>
+            const DataType_* lower_left_memory(const element::Tensor<DataType_, rank_, element::StorageOrder::COLUMN_MAJOR, Allocator_>& tensor,
+                    AlignedBuffer<DataType_>& buffer) {
+                if (tensor.origin() == element::Index<rank_>(0)) return tensor.data();
+                buffer.resize(tensor.size());
+                element::circular_shift<element::StorageOrder::COLUMN_MAJOR>(tensor.data(), buffer.data(), tensor.range(), element::Index<rank_>(0) - tensor.origin());
+                return buffer.data();
+            }
+            
+            /**
+             * Real values of a view in the precision of the transform, read
+             * directly from the memory of contiguous views.
+             */
+            template<typename TransformType_, typename ViewValueType_, size_t rank_>
+            const TransformType_* view_memory(const element::TensorView<ViewValueType_, rank_, element::StorageOrder::COLUMN_MAJOR>& view, 
+                    AlignedBuffer<TransformType_>& buffer) {
+                if (view.is_contiguous() && view.origin() == element::Index<rank_>(0)) {
+                    return input_memory(static_cast<const ViewValueType_*>(view.data()), view.size(), buffer);
+                }
+                buffer.resize(view.size());
+                for (size_t id = 0; id < view.size(); ++id) buffer[id] = view[id];
+                return buffer.data();
+            }
+            
+            /**
+             * Forward transform of the real values in column major order
+             * written directly in the centered layout of the complex tensor,
+             * the transformer shifts the output while normalizing it. A 
+             * batch is centered in every transform, the last axis is left 
+             * as it is.
+             */
+            template<typename ValueType_, size_t rank_>
+            void forward(const element::Index<rank_>& logical_range, const typename TransformType<ValueType_>::type* real_data,
+                    element::Tensor<element::Complex<ValueType_>, rank_, element::StorageOrder::COLUMN_MAJOR>& complex,
+                    const std::shared_ptr<fft::FFTInterface>& transformer, bool batched = false) {
+                element::Index<rank_> complex_container_range = logical_range;
+                complex_container_range[0] = complex_container_range[0] / 2 + 1;
+                element::Index<rank_> origin = complex_container_range*0.5;
+                origin[0] = 0;
+                if (batched) origin[rank_ - 1] = 0;
+                complex = element::Tensor<element::Complex<ValueType_>, rank_, element::StorageOrder::COLUMN_MAJOR>(complex_container_range, origin);
+
+                ValueType_* complex_values = reinterpret_cast<ValueType_*> (complex.data());
+                AlignedBuffer<typename TransformType<ValueType_>::type> buffer;
+                auto output = output_memory(complex_values, complex.size()*2, buffer);
+                transformer->forward_fourier_batch(transform_sizes(logical_range, batched), transform_count(logical_range, batched), real_data, output, 
+                        transform_origin(origin, batched));
+                store_output(buffer, complex_values);
+            }
+            
+            /**
+             * Inverse transform of the complex tensor written directly in 
+             * the real memory of the logical range. The transformer shifts
+             * the complex values back from their origin while staging them,
+             * only a batch with an origin along its last axis is shifted 
+             * beforehand.
+             */
+            template<typename ValueType_, size_t rank_, typename Allocator_>
+            void inverse(const element::Index<rank_>& logical_range,
+                    const element::Tensor<element::Complex<ValueType_>, rank_, element::StorageOrder::COLUMN_MAJOR, Allocator_>& complex,
+                    ValueType_* real_data,
+                    const std::shared_ptr<fft::FFTInterface>& transformer, bool batched = false) {
+                const std::vector<int> sizes = transform_sizes(logical_range, batched);
+                const size_t count = transform_count(logical_range, batched);
+                assert(fft::FFTInterface::complex_size(sizes) * count == complex.size());
+                
+                AlignedBuffer<element::Complex<ValueType_>> shifted;
+                const ValueType_* complex_values = reinterpret_cast<const ValueType_*> (complex.data());
+                std::vector<int> origin = transform_origin(complex.origin(), batched);
+                if (batched && complex.origin()[rank_ - 1] != 0) {
+                    complex_values = reinterpret_cast<const ValueType_*> (lower_left_memory(complex, shifted));
+                    origin.assign(origin.size(), 0);
+                }
+                
+                AlignedBuffer<typename TransformType<ValueType_>::type> input_buffer, output_buffer;
+                auto input = input_memory(complex_values, complex.size()*2, input_buffer);
+                auto output = output_memory(real_data, logical_range.size(), output_buffer);
+                transformer->inverse_fourier_batch(sizes, count, input, output, origin);
+                store_output(output_buffer, real_data);
+            }
+            
+            /**
+             * Complex to complex transform of the complex tensor into a new
+             * tensor of the same range. The forward transform is centered 
+             * at range/2, the inverse one has the origin at the lower left 
+             * corner. The input can have any origin, it is shifted by the
+             * transformer together with the normalization.
+             */
+            template<typename ValueType_, size_t rank_>
+            void complex_transform(const object::ComplexObject<ValueType_, rank_>& input, object::ComplexObject<ValueType_, rank_>& output,
+                    const std::shared_ptr<fft::FFTInterface>& transformer, bool forward) {
+                using transform_type = typename TransformType<ValueType_>::type;
+                const element::Index<rank_> range = input.range();
+                const element::Index<rank_> origin = forward ? range*0.5 : element::Index<rank_>(0);
+                object::ComplexObject<ValueType_, rank_> result(range, origin);
+                
+                //The input of the forward transform is shifted to the lower
+                //left corner first
+                AlignedBuffer<element::Complex<ValueType_>> shifted;
+                const element::Complex<ValueType_>* source = forward ? lower_left_memory(input, shifted) : input.data();
+                
+                const size_t size = input.size()*2;
+                AlignedBuffer<transform_type> input_buffer, output_buffer;
+                auto input_data = input_memory(reinterpret_cast<const ValueType_*> (source), size, input_buffer);
+                auto output_data = output_memory(reinterpret_cast<ValueType_*> (result.data()), size, output_buffer);
+                if (forward) {
+                    transformer->forward_complex_fourier(transform_sizes(range), input_data, output_data, transform_origin(origin));
+                } else {
+                    transformer->inverse_complex_fourier(transform_sizes(range), input_data, output_data, transform_origin(input.origin()));
+                }
+                store_output(output_buffer, reinterpret_cast<ValueType_*> (result.data()));
+                output = std::move(result);
+            }
+            
+            /**
+             * Complex to complex transform in the memory of the tensor. The
+             * values are moved to the lower left corner in place before the
+             * transform, the forward transform is then centered in place.
+             */
+            template<typename ValueType_, size_t rank_>
+            void complex_transform(object::ComplexObject<ValueType_, rank_>& data,
+                    const std::shared_ptr<fft::FFTInterface>& transformer, bool forward) {
+                using transform_type = typename TransformType<ValueType_>::type;
+                data.transform_origin(element::Index<rank_>(0));
+                
+                //The memory of the tensor, or a converted copy transformed
+                //in place and stored back
+                ValueType_* values = reinterpret_cast<ValueType_*> (data.data());
+                AlignedBuffer<transform_type> buffer;
+                transform_type* memory = const_cast<transform_type*> (input_memory(values, data.size()*2, buffer));
+                if (forward) {
+                    transformer->forward_complex_fourier(transform_sizes(data.range()), memory, memory, std::vector<int>());
+                } else {
+                    transformer->inverse_complex_fourier(transform_sizes(data.range()), memory, memory, std::vector<int>());
+                }
+                store_output(buffer, values);
+                
+                if (forward) data.transform_origin(data.range()*0.5);
+            }
+        }
+        
         /**
-         * REAL to COMPLEX FFT Tensor conversion
+         * REAL to COMPLEX FFT conversion of the real data provided in the 
+         * column major order
          * @param logical_range
-         * @param real
+         * @param real_data
          * @param complex
          */
         template<typename ValueType_, size_t rank_>
         void fourier_transform(const element::Index<rank_>& logical_range,
-                const element::Tensor<ValueType_, rank_, element::StorageOrder::COLUMN_MAJOR>& real,
+                const fft::AlignedVector& real_data,
                 element::Tensor<element::Complex<ValueType_>, rank_, element::StorageOrder::COLUMN_MAJOR>& complex, 
                 std::shared_ptr<fft::FFTInterface> transformer = fft::FFTEnvironment::Instance().global_transformer()) {
 
             //Check the provided size
-            assert(logical_range.size() <= real.range().size());
-
-            //Do the FFT
-            std::vector<int> sizes;
-            for (int i = 0; i < rank_; ++i) sizes.push_back((int) logical_range[i]);
-            auto output = transformer->forward_fourier(sizes, real.vectorize());
-
-            //Create the complex valued tensor
-            element::Index<rank_> complex_container_range = logical_range;
-            complex_container_range[0] = complex_container_range[0] / 2 + 1;
-            element::Index<rank_> origin = complex_container_range*0.5;
-            origin[0] = 0;
-            complex = element::Tensor<element::Complex<ValueType_>, rank_, element::StorageOrder::COLUMN_MAJOR>(complex_container_range, element::Complex<ValueType_>());
-
-            for (int id = 0; id < complex.range().size(); id++) {
-                complex[id] = element::Complex<ValueType_>((ValueType_) output[2 * id], (ValueType_) output[2 * id + 1]);
-            };
+            assert(logical_range.size() <= real_data.size());
+            fourier_impl::AlignedBuffer<typename fourier_impl::TransformType<ValueType_>::type> buffer;
+            fourier_impl::forward(logical_range, fourier_impl::input_memory(real_data.data(), logical_range.size(), buffer), complex, transformer);
+        }
+        
+        /**
+         * REAL to COMPLEX FFT Tensor conversion. The transform reads the
+         * memory of the real tensor and writes in the memory of the 
+         * complex tensor without intermediate copies for double and float
+         * tensors with the origin at the lower left corner. Float tensors
+         * are transformed in single precision.
+         * @param logical_range
+         * @param real
+         * @param complex
+         */
+        template<typename ValueType_, size_t rank_, typename Allocator_>
+        void fourier_transform(const element::Index<rank_>& logical_range,
+                const element::Tensor<ValueType_, rank_, element::StorageOrder::COLUMN_MAJOR, Allocator_>& real,
+                element::Tensor<element::Complex<ValueType_>, rank_, element::StorageOrder::COLUMN_MAJOR>& complex, 
+                std::shared_ptr<fft::FFTInterface> transformer = fft::FFTEnvironment::Instance().global_transformer()) {
+            
+            //Check the provided size
+            assert(logical_range.size() <= real.size());
             
-            complex.transform_origin(origin);
+            fourier_impl::AlignedBuffer<ValueType_> shifted;
+            fourier_impl::AlignedBuffer<typename fourier_impl::TransformType<ValueType_>::type> buffer;
+            const ValueType_* real_data = fourier_impl::lower_left_memory(real, shifted);
+            fourier_impl::forward(logical_range, fourier_impl::input_memory(real_data, logical_range.size(), buffer), complex, transformer);
         }
 
         /**
-         * COMPLEX TO REAL InverseFFT Tensor conversion
+         * COMPLEX TO REAL InverseFFT Tensor conversion. The complex tensor
+         * can have any origin, the transform is written directly in the
+         * memory of the real tensor.
          * @param logical_range
          * @param complex
          * @param real
          */
         template<typename ValueType_, size_t rank_>
         void fourier_transform(const element::Index<rank_>& logical_range,
-                const element::Tensor<element::Complex<ValueType_>, rank_, element::StorageOrder::COLUMN_MAJOR>& complex_in,
+                const element::Tensor<element::Complex<ValueType_>, rank_, element::StorageOrder::COLUMN_MAJOR>& complex,
                 element::Tensor<ValueType_, rank_, element::StorageOrder::COLUMN_MAJOR>& real,
                 std::shared_ptr<fft::FFTInterface> transformer = fft::FFTEnvironment::Instance().global_transformer()) {
 
-            //Check the provided size
-            assert(logical_range.size() <= complex_in.range().size()*2);
-            //Index<rank_> lower_left_origin(0);
-            auto complex = complex_in;
-            //complex.transform_origin(lower_left_origin);
-
-            std::vector<double> input = std::vector<double>(complex.range().size()*2);
-            for (int id = 0; id < complex.range().size(); id++) {
-                input[2 * id] = (double) complex[id].real();
-                input[2 * id + 1] = (double) complex[id].imag();
-            };
-
-            //Do the FFT
-            std::vector<int> sizes;
-            for (int i = 0; i < rank_; ++i) sizes.push_back((int) logical_range[i]);
-            auto output = transformer->inverse_fourier(sizes, input);
-
-            //Create the complex valued tensor
-            real = element::Tensor<ValueType_, rank_, element::StorageOrder::COLUMN_MAJOR>(logical_range, output);
+            element::Tensor<ValueType_, rank_, element::StorageOrder::COLUMN_MAJOR> result(logical_range);
+            fourier_impl::inverse(logical_range, complex, result.data(), transformer);
+            real = std::move(result);
         }
         
         
@@ -104,7 +350,7 @@ namespace em {
                                std::shared_ptr<fft::FFTInterface> transformer = fft::FFTEnvironment::Instance().global_transformer()) {
             object::ComplexHalfObject<ValueType_, rank_> complex_tensor;
             fourier_transform(real.range(), real, complex_tensor, transformer);
-            complex = object::ComplexHalfObject<ValueType_, rank_>(complex_tensor, (real.range().at(0)%2 == 0));
+            complex = object::ComplexHalfObject<ValueType_, rank_>(std::move(complex_tensor), (real.range().at(0)%2 == 0));
         }
         
         template<typename ValueType_, size_t rank_>
@@ -113,8 +359,166 @@ namespace em {
                                std::shared_ptr<fft::FFTInterface> transformer = fft::FFTEnvironment::Instance().global_transformer()) {
             fourier_transform(complex.logical_range(), complex, real, transformer);
         }
+        
+        /**
+         * REAL to COMPLEX FFT of a view (e.g. a slice of a stack). The
+         * elements are read directly from the memory of the parent tensor,
+         * which can hold a different type (e.g. a stack of floats mapped
+         * from a file).
+         */
+        template<typename ViewValueType_, typename ValueType_, size_t rank_>
+        void fourier_transform(const element::TensorView<ViewValueType_, rank_, element::StorageOrder::COLUMN_MAJOR>& real, 
+                               object::ComplexHalfObject<ValueType_, rank_>& complex,
+                               std::shared_ptr<fft::FFTInterface> transformer = fft::FFTEnvironment::Instance().global_transformer()) {
+            fourier_impl::AlignedBuffer<typename fourier_impl::TransformType<ValueType_>::type> buffer;
+            object::ComplexHalfObject<ValueType_, rank_> complex_tensor;
+            fourier_impl::forward(real.range(), fourier_impl::view_memory(real, buffer), complex_tensor, transformer);
+            complex = object::ComplexHalfObject<ValueType_, rank_>(std::move(complex_tensor), (real.range().at(0)%2 == 0));
+        }
+        
+        /**
+         * COMPLEX to REAL inverse FFT writing the result in the memory 
+         * referred by the view (e.g. a slice of a stack).
+         */
+        template<typename ValueType_, size_t rank_>
+        void fourier_transform(const object::ComplexHalfObject<ValueType_, rank_>& complex, 
+                               element::TensorView<ValueType_, rank_, element::StorageOrder::COLUMN_MAJOR> real,
+                               std::shared_ptr<fft::FFTInterface> transformer = fft::FFTEnvironment::Instance().global_transformer()) {
+            assert(complex.logical_range() == real.range());
+            if (real.is_contiguous() && real.origin() == element::Index<rank_>(0)) {
+                fourier_impl::inverse(complex.logical_range(), complex, real.data(), transformer);
+            } else {
+                object::RealObject<ValueType_, rank_> real_tensor;
+                fourier_transform(complex.logical_range(), complex, real_tensor, transformer);
+                real.assign(real_tensor);
+            }
+        }
+        
+        /**
+         * COMPLEX to COMPLEX FFT of a complex tensor (e.g. a wave function
+         * or a phase plate). The transform is normalized by 1/sqrt(N) 
+         * with the sign of the real transforms, hence the transform of a 
+         * complex tensor with no imaginary part is the full version of its
+         * real transform. The zero frequency of the result is at range/2. 
+         * The transform reads and writes the memory of the tensors 
+         * directly for double and float tensors (the latter in single
+         * precision).
+         * @param input: can have any origin
+         * @param output
+         */
+        template<typename ValueType_, size_t rank_>
+        void fourier_transform(const object::ComplexObject<ValueType_, rank_>& input, 
+                               object::ComplexObject<ValueType_, rank_>& output,
+                               std::shared_ptr<fft::FFTInterface> transformer = fft::FFTEnvironment::Instance().global_transformer()) {
+            fourier_impl::complex_transform(input, output, transformer, true);
+        }
+        
+        /**
+         * COMPLEX to COMPLEX FFT in place, the origin of the tensor is 
+         * moved to range/2.
+         */
+        template<typename ValueType_, size_t rank_>
+        void fourier_transform(object::ComplexObject<ValueType_, rank_>& data,
+                               std::shared_ptr<fft::FFTInterface> transformer = fft::FFTEnvironment::Instance().global_transformer()) {
+            fourier_impl::complex_transform(data, transformer, true);
+        }
+        
+        /**
+         * COMPLEX to COMPLEX inverse FFT of a complex tensor. The input
+         * can have any origin (e.g. the output of fourier_transform()), 
+         * the result has its origin at the lower left corner.
+         * @param input
+         * @param output
+         */
+        template<typename ValueType_, size_t rank_>
+        void inverse_fourier_transform(const object::ComplexObject<ValueType_, rank_>& input, 
+                                       object::ComplexObject<ValueType_, rank_>& output,
+                                       std::shared_ptr<fft::FFTInterface> transformer = fft::FFTEnvironment::Instance().global_transformer()) {
+            fourier_impl::complex_transform(input, output, transformer, false);
+        }
+        
+        /**
+         * COMPLEX to COMPLEX inverse FFT in place, the origin of the 
+         * tensor is moved to the lower left corner.
+         */
+        template<typename ValueType_, size_t rank_>
+        void inverse_fourier_transform(object::ComplexObject<ValueType_, rank_>& data,
+                                       std::shared_ptr<fft::FFTInterface> transformer = fft::FFTEnvironment::Instance().global_transformer()) {
+            fourier_impl::complex_transform(data, transformer, false);
+        }
+        
+        /**
+         * REAL to COMPLEX FFTs of the images of a stack. The last axis is
+         * the index of the images, which are transformed together by the
+         * transformer (with FFTW plans of many transforms) directly from 
+         * the memory of the stack. Each image of the result is centered 
+         * as by fourier_transform(), i.e. the slices of the result are the
+         * transforms of the slices of the stack.
+         * @param stack
+         * @param complex: stack of the transforms
+         */
+        template<typename ValueType_, size_t rank_>
+        void fourier_transform_batch(const object::RealObject<ValueType_, rank_>& stack, 
+                                     object::ComplexHalfObject<ValueType_, rank_>& complex,
+                                     std::shared_ptr<fft::FFTInterface> transformer = fft::FFTEnvironment::Instance().global_transformer()) {
+            static_assert(rank_ > 1, "The rank should be more than 1 for a batch");
+            fourier_impl::AlignedBuffer<ValueType_> shifted;
+            fourier_impl::AlignedBuffer<typename fourier_impl::TransformType<ValueType_>::type> buffer;
+            const ValueType_* real_data = fourier_impl::lower_left_memory(stack, shifted);
+            
+            object::ComplexHalfObject<ValueType_, rank_> complex_tensor;
+            fourier_impl::forward(stack.range(), fourier_impl::input_memory(real_data, stack.size(), buffer), complex_tensor, transformer, true);
+            complex = object::ComplexHalfObject<ValueType_, rank_>(std::move(complex_tensor), (stack.range().at(0)%2 == 0));
+        }
+        
+        /**
+         * REAL to COMPLEX FFTs of the images of a view of a stack (e.g. a 
+         * section of consecutive images of a mapped stack). 
+         */
+        template<typename ViewValueType_, typename ValueType_, size_t rank_>
+        void fourier_transform_batch(const element::TensorView<ViewValueType_, rank_, element::StorageOrder::COLUMN_MAJOR>& stack, 
+                                     object::ComplexHalfObject<ValueType_, rank_>& complex,
+                                     std::shared_ptr<fft::FFTInterface> transformer = fft::FFTEnvironment::Instance().global_transformer()) {
+            static_assert(rank_ > 1, "The rank should be more than 1 for a batch");
+            fourier_impl::AlignedBuffer<typename fourier_impl::TransformType<ValueType_>::type> buffer;
+            object::ComplexHalfObject<ValueType_, rank_> complex_tensor;
+            fourier_impl::forward(stack.range(), fourier_impl::view_memory(stack, buffer), complex_tensor, transformer, true);
+            complex = object::ComplexHalfObject<ValueType_, rank_>(std::move(complex_tensor), (stack.range().at(0)%2 == 0));
+        }
+        
+        /**
+         * COMPLEX to REAL inverse FFTs of the images of a stack of 
+         * transforms (see fourier_transform_batch()).
+         */
+        template<typename ValueType_, size_t rank_>
+        void fourier_transform_batch(const object::ComplexHalfObject<ValueType_, rank_>& complex, 
+                                     object::RealObject<ValueType_, rank_>& stack,
+                                     std::shared_ptr<fft::FFTInterface> transformer = fft::FFTEnvironment::Instance().global_transformer()) {
+            static_assert(rank_ > 1, "The rank should be more than 1 for a batch");
+            object::RealObject<ValueType_, rank_> result(complex.logical_range());
+            fourier_impl::inverse(complex.logical_range(), complex, result.data(), transformer, true);
+            stack = std::move(result);
+        }
+        
+        /**
+         * COMPLEX to REAL inverse FFTs of the images of a stack of 
+         * transforms written in the memory referred by the view (e.g. a 
+         * section of consecutive images of a stack).
+         */
+        template<typename ValueType_, size_t rank_>
+        void fourier_transform_batch(const object::ComplexHalfObject<ValueType_, rank_>& complex, 
+                                     element::TensorView<ValueType_, rank_, element::StorageOrder::COLUMN_MAJOR> stack,
+                                     std::shared_ptr<fft::FFTInterface> transformer = fft::FFTEnvironment::Instance().global_transformer()) {
+            assert(complex.logical_range() == stack.range());
+            if (stack.is_contiguous() && stack.origin() == element::Index<rank_>(0)) {
+                fourier_impl::inverse(complex.logical_range(), complex, stack.data(), transformer, true);
+            } else {
+                object::RealObject<ValueType_, rank_> real_tensor;
+                fourier_transform_batch(complex, real_tensor, transformer);
+                stack.assign(real_tensor);
+            }
+        }
     }
 }
 
 #endif /* FOURIER_TRANSFORM_HPP */
-
@@ -21,31 +21,93 @@
 
 #include <iterator>
 #include <numeric>
+#include <limits>
+#include <utility>
+#include <cmath>
+#include <type_traits>
+
+#include "../parallel/parallel_algorithm.hpp"
 
 namespace em {
 
     namespace algorithm {
+        
+        /**
+         * The statistics are computed in parallel on blocks of the range
+         * (see em::parallel). The partial results of the blocks are combined
+         * in order, so the results are reproducible.
+         */
+        
+        namespace numerics_impl {
+            
+            template<typename TensorIterator_>
+            using value_type = typename std::remove_const<typename std::iterator_traits<TensorIterator_>::value_type::value_type>::type;
+            
+            /**
+             * Finds the position of the first element which is not less 
+             * than any other element using the comparator
+             */
+            template<typename TensorIterator_, typename Compare_>
+            TensorIterator_ extremum(TensorIterator_ begin, TensorIterator_ end, const Compare_& less) {
+                using data_type = value_type<TensorIterator_>;
+                using result_type = std::pair<size_t, data_type>;
+                const size_t none = std::numeric_limits<size_t>::max();
+                
+                size_t size = std::distance(begin, end);
+                result_type result = parallel::parallel_reduce_blocks(size, parallel::block_size<data_type>(), result_type(none, data_type()),
+                    [&](size_t first, size_t last) {
+                        auto itr = begin + first;
+                        result_type best(first, element::value(*itr));
+                        for (size_t id = first; id < last; ++id, ++itr) {
+                            if (less(best.second, element::value(*itr))) best = result_type(id, element::value(*itr));
+                        }
+                        return best;
+                    },
+                    [&](const result_type& current, const result_type& next) {
+                        if (current.first == none || (next.first != none && less(current.second, next.second))) return next;
+                        return current;
+                    });
+                
+                return result.first == none ? end : begin + result.first;
+            }
+            
+            /**
+             * Sums the values transformed with the function
+             */
+            template<typename TensorIterator_, typename Function_>
+            value_type<TensorIterator_> transformed_sum(TensorIterator_ begin, TensorIterator_ end, const Function_& function) {
+                using data_type = value_type<TensorIterator_>;
+                return parallel::parallel_reduce_blocks(std::distance(begin, end), parallel::block_size<data_type>(), data_type(),
+                    [&](size_t first, size_t last) {
+                        data_type total = data_type();
+                        auto itr = begin + first;
+                        for (size_t id = first; id < last; ++id, ++itr) total = total + function(element::value(*itr));
+                        return total;
+                    },
+                    [](const data_type& total, const data_type& partial) {
+                        return total + partial;
+                    });
+            }
+        }
 
         template<typename TensorIterator_>
         typename std::iterator_traits<TensorIterator_>::value_type
         max(TensorIterator_ begin, TensorIterator_ end) {
-            using pair_type = typename std::iterator_traits<TensorIterator_>::value_type;
-            return *std::max_element(begin, end,
-                    [] (const pair_type & p1, const pair_type & p2) {
-                        return element::value(p1) < element::value(p2);
+            using data_type = numerics_impl::value_type<TensorIterator_>;
+            return *numerics_impl::extremum(begin, end, [] (const data_type& v1, const data_type& v2) {
+                        return v1 < v2;
                     });
         }
         
         template<typename TensorIterator_>
         typename std::iterator_traits<TensorIterator_>::value_type
         min(TensorIterator_ begin, TensorIterator_ end) {
-            using pair_type = typename TensorIterator_::value_type;
-            return *std::max_element(begin, end,
-                    [] (const pair_type & p1, const pair_type & p2) {
-                        return element::value(p1) > element::value(p2);
+            using data_type = numerics_impl::value_type<TensorIterator_>;
+            return *numerics_impl::extremum(begin, end, [] (const data_type& v1, const data_type& v2) {
+                        return v1 > v2;
                     });
         }
-        
+
         template<typename TensorIterator_>
         typename std::iterator_traits<TensorIterator_>::value_type::value_type
         max_value(TensorIterator_ begin, TensorIterator_ end) {
@@ -73,24 +135,19 @@ namespace em {
         template<typename TensorIterator_>
         typename std::iterator_traits<TensorIterator_>::value_type::value_type
         sum(TensorIterator_ begin, TensorIterator_ end) {
-            using pair_type = typename TensorIterator_::value_type;
-            using value_type = typename pair_type::value_type;
-            return std::accumulate(begin, end, value_type(),
-                    [] (int total, const pair_type & p) {
-                        return total + p.value();
+            using data_type = numerics_impl::value_type<TensorIterator_>;
+            return numerics_impl::transformed_sum(begin, end, [] (const data_type& val) {
+                        return val;
                     });
         }
         
         template<typename TensorIterator_>
         typename std::iterator_traits<TensorIterator_>::value_type::value_type
         squared_sum(TensorIterator_ begin, TensorIterator_ end) {
-            using value_type = typename TensorIterator_::value_type::value_type;
-            value_type ss = value_type();
-            for(auto itr = begin; itr != end; ++itr) {
-                value_type val = element::value((*itr));
-                ss += val*val;
-            }
-            return ss;
+            using data_type = numerics_impl::value_type<TensorIterator_>;
+            return numerics_impl::transformed_sum(begin, end, [] (const data_type& val) {
+                        return val*val;
+                    });
         }
         
         template<typename TensorIterator_>
@@ -0,0 +1,283 @@
+/* 
+ * This file is a part of emkit.
+ * 
+ * emkit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * emkit is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>
+ * 
+ * Author:
+ * Nikhil Biyani: nikhil(dot)biyani(at)gmail(dot)com
+ * 
+ */
+
+#ifndef PADDING_HPP
+#define PADDING_HPP
+
+#include <cstddef>
+#include <cassert>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+
+#include "../modules/fft/fft_size.hpp"
+#include "../elements/tensor.hpp"
+#include "../elements/tensor_view.hpp"
+#include "../elements/tensor_storage_order.hpp"
+#include "../parallel/parallel_algorithm.hpp"
+#include "../objects/object_base_types.hpp"
+
+namespace em {
+    
+    namespace algorithm {
+        
+        /**
+         * Value of the elements added around the input by pad_to
+         */
+        enum class PaddingValue {
+            ZERO, ///< Zeros
+            MEAN  ///< Mean of the input, of every image for batches
+        };
+        
+        namespace padding_impl {
+            
+            template<typename ValueType_, size_t rank_>
+            using View = element::TensorView<ValueType_, rank_, element::StorageOrder::COLUMN_MAJOR>;
+            
+            /**
+             * Offset of a box of the inner range placed at the center of a
+             * box of the outer range
+             */
+            template<size_t rank_>
+            element::Index<rank_> center_offset(const element::Index<rank_>& outer, const element::Index<rank_>& inner) {
+                element::Index<rank_> offset;
+                for (size_t i = 0; i < rank_; ++i) offset[i] = (outer[i] - inner[i]) / 2;
+                return offset;
+            }
+            
+            /**
+             * Origin of the output referring to the same element as the
+             * origin of the input, the lower left corner if this element
+             * is not in the output.
+             */
+            template<size_t rank_>
+            element::Index<rank_> moved_origin(const element::Index<rank_>& origin, const element::Index<rank_>& shift, const element::Index<rank_>& range) {
+                element::Index<rank_> moved = origin + shift;
+                for (size_t i = 0; i < rank_; ++i) {
+                    if (moved[i] < 0 || moved[i] >= range[i]) return element::Index<rank_>(0);
+                }
+                return moved;
+            }
+            
+            /**
+             * Mean of every image of the view, the images being the slices
+             * along the last axis for batches. The sums of the rows are
+             * computed in parallel and added in order.
+             */
+            template<typename ViewValueType_, size_t rank_>
+            std::vector<double> image_means(const View<ViewValueType_, rank_>& input, bool batched) {
+                const element::Index<rank_> range = input.range();
+                const element::Index<rank_> stride = input.stride();
+                const size_t length = range[0];
+                const size_t rows = range.size() / length;
+                const size_t images = (batched && rank_ > 1) ? range[rank_ - 1] : 1;
+                
+                std::vector<double> row_sums(rows);
+                parallel::parallel_for(rows, std::max<size_t>(1, parallel::block_size<double>() / length), [&](size_t begin, size_t end) {
+                    for (size_t row = begin; row < end; ++row) {
+                        size_t remainder = row;
+                        std::ptrdiff_t offset = 0;
+                        for (size_t dim = 1; dim < rank_; ++dim) {
+                            offset += (remainder % range[dim]) * stride[dim];
+                            remainder /= range[dim];
+                        }
+                        const ViewValueType_* values = input.data() + offset;
+                        double sum = 0;
+                        for (size_t x = 0; x < length; ++x) sum += values[x * stride[0]];
+                        row_sums[row] = sum;
+                    }
+                });
+                
+                std::vector<double> means(images, 0);
+                const size_t rows_per_image = rows / images;
+                for (size_t row = 0; row < rows; ++row) means[row / rows_per_image] += row_sums[row];
+                for (auto& mean : means) mean /= rows_per_image * length;
+                return means;
+            }
+            
+            /**
+             * @brief       Copies the input to the output moved by the shift,
+             *              i.e. the element at the physical position p of 
+             *              the input is written at p + shift in the output.
+             * @description The rows of the output along x are processed in
+             *              parallel. The elements of a row which are not
+             *              covered by the input are set to fill(image), with
+             *              the image being the position of the row along 
+             *              the last axis of the input.
+             */
+            template<typename InValueType_, typename OutValueType_, size_t rank_, typename Fill_>
+            void place(const View<InValueType_, rank_>& input, const View<OutValueType_, rank_>& output,
+                    const element::Index<rank_>& shift, const Fill_& fill) {
+                using data_type = typename std::remove_const<OutValueType_>::type;
+                const element::Index<rank_> in_range = input.range();
+                const element::Index<rank_> out_range = output.range();
+                const element::Index<rank_> in_stride = input.stride();
+                const element::Index<rank_> out_stride = output.stride();
+                const std::ptrdiff_t length = out_range[0];
+                const std::ptrdiff_t x_begin = std::min(length, std::max<std::ptrdiff_t>(0, shift[0]));
+                const std::ptrdiff_t x_end = std::min(length, std::max<std::ptrdiff_t>(0, shift[0] + in_range[0]));
+                
+                parallel::parallel_for(out_range.size() / length, std::max<size_t>(1, parallel::block_size<data_type>() / length), [&](size_t begin, size_t end) {
+                    for (size_t row = begin; row < end; ++row) {
+                        size_t remainder = row;
+                        std::ptrdiff_t in_offset = 0, out_offset = 0, image = 0;
+                        bool inside = true;
+                        for (size_t dim = 1; dim < rank_; ++dim) {
+                            const std::ptrdiff_t position = remainder % out_range[dim];
+                            remainder /= out_range[dim];
+                            out_offset += position * out_stride[dim];
+                            const std::ptrdiff_t source = position - shift[dim];
+                            if (source < 0 || source >= in_range[dim]) inside = false;
+                            else in_offset += source * in_stride[dim];
+                            if (dim == rank_ - 1) image = std::min(std::max<std::ptrdiff_t>(0, source), in_range[dim] - 1);
+                        }
+                        
+                        OutValueType_* target = output.data() + out_offset;
+                        if (!inside) {
+                            const data_type value = fill(image);
+                            for (std::ptrdiff_t x = 0; x < length; ++x) target[x * out_stride[0]] = value;
+                            continue;
+                        }
+                        
+                        const InValueType_* source = input.data() + in_offset - shift[0] * in_stride[0];
+                        if (x_begin > 0 || x_end < length) {
+                            const data_type value = fill(image);
+                            for (std::ptrdiff_t x = 0; x < x_begin; ++x) target[x * out_stride[0]] = value;
+                            for (std::ptrdiff_t x = x_end; x < length; ++x) target[x * out_stride[0]] = value;
+                        }
+                        for (std::ptrdiff_t x = x_begin; x < x_end; ++x) target[x * out_stride[0]] = (data_type) source[x * in_stride[0]];
+                    }
+                });
+            }
+            
+        }
+        
+        /**
+         * Range with good FFT sizes (see fft::good_size) containing the 
+         * given range, with an even first dimension. The last axis of a 
+         * batch is kept.
+         */
+        template<size_t rank_>
+        element::Index<rank_> good_fft_range(const element::Index<rank_>& range, bool batched = false) {
+            element::Index<rank_> good;
+            for (size_t i = 0; i < rank_; ++i) good[i] = fft::good_size(range[i], i == 0);
+            if (batched) good[rank_ - 1] = range[rank_ - 1];
+            return good;
+        }
+        
+        /**
+         * @brief       Pads the real values to a larger range, e.g. to a 
+         *              good FFT range before a transform.
+         * @description The input is placed at the center of the output, 
+         *              with the offset (range - input range)/2 along every
+         *              axis, as it is stored (physical positions). The 
+         *              origin of the output refers to the same element as
+         *              the origin of the input. The added elements are zero
+         *              or the mean of the input; for batches the last axis 
+         *              must not be padded and every image is padded with 
+         *              its own mean. The rows are copied in parallel.
+         * @param       input: real values or a section of a stack
+         * @param       range: range of the output, not smaller than the 
+         *              input range
+         * @param       output
+         * @param       value: value of the added elements
+         * @param       batched: the last axis holds the images of a stack
+         */
+        template<typename ViewValueType_, typename ValueType_, size_t rank_>
+        void pad_to(const element::TensorView<ViewValueType_, rank_, element::StorageOrder::COLUMN_MAJOR>& input, 
+                const element::Index<rank_>& range, object::RealObject<ValueType_, rank_>& output,
+                PaddingValue value = PaddingValue::MEAN, bool batched = false) {
+            for (size_t i = 0; i < rank_; ++i) assert(range[i] >= input.range()[i]);
+            assert(!batched || range[rank_ - 1] == input.range()[rank_ - 1]);
+            
+            const element::Index<rank_> offset = padding_impl::center_offset(range, input.range());
+            object::RealObject<ValueType_, rank_> padded(range, padding_impl::moved_origin(input.origin(), offset, range));
+            
+            std::vector<double> means;
+            if (value == PaddingValue::MEAN) means = padding_impl::image_means(input, batched);
+            padding_impl::place(input, padded.view(), offset, [&](std::ptrdiff_t image) {
+                if (means.empty()) return ValueType_();
+                return (ValueType_) means[means.size() == 1 ? 0 : image];
+            });
+            output = std::move(padded);
+        }
+        
+        template<typename ValueType_, size_t rank_>
+        void pad_to(const object::RealObject<ValueType_, rank_>& input, const element::Index<rank_>& range,
+                object::RealObject<ValueType_, rank_>& output, PaddingValue value = PaddingValue::MEAN, bool batched = false) {
+            pad_to(input.view(), range, output, value, batched);
+        }
+        
+        /**
+         * Pads the real values to the good FFT range of their range (see 
+         * good_fft_range).
+         */
+        template<typename ValueType_, size_t rank_>
+        void pad_to_good_size(const object::RealObject<ValueType_, rank_>& input, object::RealObject<ValueType_, rank_>& output, 
+                PaddingValue value = PaddingValue::MEAN, bool batched = false) {
+            pad_to(input.view(), good_fft_range(input.range(), batched), output, value, batched);
+        }
+        
+        /**
+         * @brief       Crops the central box of the given range, the 
+         *              inverse of pad_to, e.g. after a transform of padded
+         *              values.
+         * @description The box starts at (input range - range)/2 along 
+         *              every axis. The origin of the output refers to the 
+         *              same element as the origin of the input if it is 
+         *              kept, otherwise it is at the lower left corner.
+         * @param       input: real values
+         * @param       range: range of the output, not larger than the 
+         *              input range
+         * @param       output
+         */
+        template<typename ViewValueType_, typename ValueType_, size_t rank_>
+        void crop_to(const element::TensorView<ViewValueType_, rank_, element::StorageOrder::COLUMN_MAJOR>& input, 
+                const element::Index<rank_>& range, object::RealObject<ValueType_, rank_>& output) {
+            for (size_t i = 0; i < rank_; ++i) assert(range[i] <= input.range()[i]);
+            
+            const element::Index<rank_> offset = padding_impl::center_offset(input.range(), range);
+            object::RealObject<ValueType_, rank_> cropped(range, padding_impl::moved_origin(input.origin(), (element::Index<rank_>(0) - offset), range));
+            padding_impl::place(input, cropped.view(), (element::Index<rank_>(0) - offset), [](std::ptrdiff_t) {
+                return ValueType_();
+            });
+            output = std::move(cropped);
+        }
+        
+        template<typename ValueType_, size_t rank_>
+        void crop_to(const object::RealObject<ValueType_, rank_>& input, const element::Index<rank_>& range, object::RealObject<ValueType_, rank_>& output) {
+            crop_to(input.view(), range, output);
+        }
+        
+        /**
+         * Crops the central box of the range of the output view into it,
+         * e.g. to write the images back into a section of a stack.
+         */
+        template<typename ValueType_, typename ViewValueType_, size_t rank_>
+        void crop_to(const object::RealObject<ValueType_, rank_>& input, 
+                const element::TensorView<ViewValueType_, rank_, element::StorageOrder::COLUMN_MAJOR>& output) {
+            for (size_t i = 0; i < rank_; ++i) assert(output.range()[i] <= input.range()[i]);
+            padding_impl::place(input.view(), output, element::Index<rank_>(0) - padding_impl::center_offset(input.range(), output.range()), [](std::ptrdiff_t) {
+                return ViewValueType_();
+            });
+        }
+        
+    }
+}
+
+#endif /* PADDING_HPP */
@@ -0,0 +1,237 @@
+/* 
+ * This file is a part of emkit.
+ * 
+ * emkit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * emkit is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>
+ * 
+ * Author:
+ * Nikhil Biyani: nikhil(dot)biyani(at)gmail(dot)com
+ * 
+ */
+
+#ifndef POWER_SPECTRUM_HPP
+#define POWER_SPECTRUM_HPP
+
+#include <cstddef>
+#include <cassert>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+
+#include "../modules/fft/fft_environment.hpp"
+#include "../elements/complex.hpp"
+#include "../elements/tensor_view.hpp"
+#include "../objects/object_base_types.hpp"
+#include "../objects/complex_half_object.hpp"
+#include "../parallel/parallel_algorithm.hpp"
+#include "fourier_transform.hpp"
+#include "resolution_map.hpp"
+
+namespace em {
+    
+    namespace algorithm {
+        
+        namespace spectrum_impl {
+            
+            /**
+             * Adds the intensities of the elements [begin, end) of a 
+             * Hermitian half to the power of their shells, weighted with 
+             * their multiplicity in the full Fourier space. The weights 
+             * are added to the counts if given.
+             */
+            template<typename ValueType_, size_t rank_>
+            void accumulate(const element::Complex<ValueType_>* values, const ResolutionMap<rank_>& map, size_t shells,
+                    size_t begin, size_t end, double* power, double* counts = nullptr) {
+                const size_t length = map.squared_radii().range()[0];
+                const int* shell_ids = map.shells().data();
+                for (size_t id = begin; id < end; ++id) {
+                    const size_t shell = shell_ids[id];
+                    if (shell >= shells) continue;
+                    const int weight = map.multiplicity(id % length);
+                    power[shell] += weight * (double) values[id].intensity();
+                    if (counts) counts[shell] += weight;
+                }
+            }
+            
+            /**
+             * Weighted number of elements in every shell of the map
+             */
+            template<size_t rank_>
+            std::vector<double> shell_counts(const ResolutionMap<rank_>& map, size_t shells) {
+                std::vector<double> counts(shells, 0);
+                const size_t length = map.squared_radii().range()[0];
+                const int* shell_ids = map.shells().data();
+                for (size_t id = 0; id < map.size(); ++id) {
+                    if ((size_t) shell_ids[id] < shells) counts[shell_ids[id]] += map.multiplicity(id % length);
+                }
+                return counts;
+            }
+            
+            /**
+             * Spectra of the images of a batch of transforms written in the
+             * rows of the output, one image per task. The power of an image
+             * is accumulated directly in its row and divided by the counts.
+             */
+            template<typename ValueType_, size_t rank_>
+            void batch_spectra(const object::ComplexHalfObject<ValueType_, rank_>& stack, const ResolutionMap<rank_ - 1>& map,
+                    const std::vector<double>& counts, double* spectra) {
+                const size_t shells = counts.size();
+                const size_t images = stack.logical_range()[rank_ - 1];
+                const size_t image_size = map.size();
+                assert(image_size * images == stack.size());
+                parallel::parallel_for(images, 1, [&](size_t begin, size_t end) {
+                    for (size_t image = begin; image < end; ++image) {
+                        double* power = spectra + image * shells;
+                        std::fill(power, power + shells, 0.0);
+                        accumulate(stack.data() + image * image_size, map, shells, 0, image_size, power);
+                        for (size_t shell = 0; shell < shells; ++shell) {
+                            if (counts[shell] > 0) power[shell] /= counts[shell];
+                        }
+                    }
+                });
+            }
+            
+        }
+        
+        /**
+         * @brief       Rotationally averaged power spectrum of a transform,
+         *              i.e. the mean intensity in every shell of its 
+         *              resolution map.
+         * @description The Hermitian half is read in a single parallel 
+         *              pass, the elements being counted with their Friedel
+         *              mates. The blocks of the storage accumulate in their 
+         *              own shell sums, which are added in order at the end.
+         * @param       complex: transform of an image or a volume
+         * @param       shells: number of shells, all the shells for 0
+         * @return      mean intensity of the shells, the shell s being at 
+         *              the resolution map->shell_radius(s)
+         */
+        template<typename ValueType_, size_t rank_>
+        std::vector<double> radial_power_spectrum(const object::ComplexHalfObject<ValueType_, rank_>& complex, size_t shells = 0) {
+            auto map = resolution_map(complex);
+            shells = reported_shells(*map, shells);
+            
+            //Power of the shells followed by their counts
+            using sums_type = std::vector<double>;
+            sums_type sums = parallel::parallel_reduce_blocks(map->size(), parallel::block_size<element::Complex<ValueType_>>(), sums_type(2 * shells, 0),
+                [&](size_t begin, size_t end) {
+                    sums_type block(2 * shells, 0);
+                    spectrum_impl::accumulate(complex.data(), *map, shells, begin, end, block.data(), block.data() + shells);
+                    return block;
+                },
+                [](sums_type total, const sums_type& partial) {
+                    for (size_t i = 0; i < total.size(); ++i) total[i] += partial[i];
+                    return total;
+                });
+            
+            std::vector<double> spectrum(sums.begin(), sums.begin() + shells);
+            for (size_t shell = 0; shell < shells; ++shell) {
+                if (sums[shells + shell] > 0) spectrum[shell] /= sums[shells + shell];
+            }
+            return spectrum;
+        }
+        
+        /**
+         * Rotationally averaged power spectrum of a real image or volume
+         */
+        template<typename ValueType_, size_t rank_>
+        std::vector<double> radial_power_spectrum(const object::RealObject<ValueType_, rank_>& real, size_t shells = 0,
+                std::shared_ptr<fft::FFTInterface> transformer = fft::FFTEnvironment::Instance().global_transformer()) {
+            object::ComplexHalfObject<ValueType_, rank_> complex;
+            fourier_transform(real, complex, transformer);
+            return radial_power_spectrum(complex, shells);
+        }
+        
+        /**
+         * @brief       Power spectra of the images of a batch of transforms
+         *              (see fourier_transform_batch).
+         * @description All the images share the resolution map of the 
+         *              image layout, every image is averaged by its own 
+         *              task directly into its row of the output.
+         * @param       stack: transforms, the last axis being the image
+         * @param       spectra: range (shells, images), the spectrum of 
+         *              every image
+         * @param       shells: number of shells, all the shells for 0
+         */
+        template<typename ValueType_>
+        void radial_power_spectra_batch(const object::ComplexHalfObject<ValueType_, 3>& stack, object::RealObject<double, 2>& spectra, size_t shells = 0) {
+            auto map = image_resolution_map(stack);
+            shells = reported_shells(*map, shells);
+            const std::vector<double> counts = spectrum_impl::shell_counts(*map, shells);
+            
+            const element::Index<2> range({(std::ptrdiff_t) shells, stack.logical_range()[2]});
+            if (spectra.range() != range || spectra.origin() != element::Index<2>(0)) spectra = object::RealObject<double, 2>(range);
+            spectrum_impl::batch_spectra(stack, *map, counts, spectra.data());
+        }
+        
+        /**
+         * @brief       Power spectra of the images of a stack streamed 
+         *              through the batched transforms.
+         * @description The stack (e.g. a mapped file) is transformed in 
+         *              sections of batch_size images. The spectra of a 
+         *              section are written directly in the output, memory
+         *              is only allocated for the transforms of a section,
+         *              never for a single image.
+         * @param       stack: real images, the last axis being the image
+         * @param       spectra: range (shells, images), the spectrum of 
+         *              every image
+         * @param       shells: number of shells, all the shells for 0
+         * @param       batch_size: number of images transformed together
+         */
+        template<typename ViewValueType_>
+        void radial_power_spectra_batch(const element::TensorView<ViewValueType_, 3, element::StorageOrder::COLUMN_MAJOR>& stack, 
+                object::RealObject<double, 2>& spectra, size_t shells = 0, size_t batch_size = 64,
+                std::shared_ptr<fft::FFTInterface> transformer = fft::FFTEnvironment::Instance().global_transformer()) {
+            using value_type = typename fourier_impl::TransformType<typename std::remove_const<ViewValueType_>::type>::type;
+            const element::Index<3> range = stack.range();
+            const size_t images = range[2];
+            batch_size = std::max<size_t>(1, std::min(batch_size, images));
+            
+            object::ComplexHalfObject<value_type, 3> complex;
+            std::shared_ptr<const ResolutionMap<2>> map;
+            std::vector<double> counts;
+            for (size_t first = 0; first < images; first += batch_size) {
+                const size_t count = std::min(batch_size, images - first);
+                fourier_transform_batch(stack.section(element::Index<3>({0, 0, (std::ptrdiff_t) first}), element::Index<3>({range[0], range[1], (std::ptrdiff_t) count})),
+                        complex, transformer);
+                if (!map) {
+                    map = image_resolution_map(complex);
+                    shells = reported_shells(*map, shells);
+                    counts = spectrum_impl::shell_counts(*map, shells);
+                    const element::Index<2> spectra_range({(std::ptrdiff_t) shells, (std::ptrdiff_t) images});
+                    if (spectra.range() != spectra_range || spectra.origin() != element::Index<2>(0)) spectra = object::RealObject<double, 2>(spectra_range);
+                }
+                spectrum_impl::batch_spectra(complex, *map, counts, spectra.data() + first * shells);
+            }
+        }
+        
+        /**
+         * Power spectrum averaged over the images, i.e. the mean of the 
+         * rows of the spectra of a stack
+         */
+        inline std::vector<double> average_power_spectrum(const object::RealObject<double, 2>& spectra) {
+            const size_t shells = spectra.range()[0];
+            const size_t images = spectra.range()[1];
+            std::vector<double> average(shells, 0);
+            const double* values = spectra.data();
+            for (size_t image = 0; image < images; ++image) {
+                for (size_t shell = 0; shell < shells; ++shell) average[shell] += values[image * shells + shell];
+            }
+            if (images > 0) {
+                for (auto& value : average) value /= images;
+            }
+            return average;
+        }
+        
+    }
+}
+
+#endif /* POWER_SPECTRUM_HPP */
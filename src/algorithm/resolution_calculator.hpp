@@ -61,7 +61,7 @@ namespace em {
         template<size_t rank_>
         double resolution(Index<rank_> index, Index<rank_> cell_lengths) {
             
-            resolution(index, cell_lengths, M_PI/2);
+            return resolution(index, cell_lengths, M_PI/2);
 
         }
 
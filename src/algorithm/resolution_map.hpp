@@ -0,0 +1,312 @@
+/* 
+ * This file is a part of emkit.
+ * 
+ * emkit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * emkit is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>
+ * 
+ * Author:
+ * Nikhil Biyani: nikhil(dot)biyani(at)gmail(dot)com
+ * 
+ */
+
+#ifndef RESOLUTION_MAP_HPP
+#define RESOLUTION_MAP_HPP
+
+#include <cstddef>
+#include <cassert>
+#include <cmath>
+#include <array>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <iostream>
+#include <algorithm>
+
+#include "../elements/index.hpp"
+#include "../elements/tensor.hpp"
+#include "../elements/tensor_storage_order.hpp"
+#include "../parallel/parallel_algorithm.hpp"
+
+namespace em {
+    
+    namespace algorithm {
+        
+        /**
+         * @brief       Resolution of every element of the Hermitian half of
+         *              a Fourier space (see ComplexHalfObject), stored in 
+         *              tensors of the same range and origin.
+         * @description For every element the map holds the squared 
+         *              reciprocal radius d*^2 = sum (h_i/cell_i)^2 of its 
+         *              Miller index h and the id of its resolution shell, 
+         *              round(d* / shell_width). The shells are one Fourier 
+         *              pixel along the longest cell axis wide, i.e. they are
+         *              the integer radii for a cubic box with the cell of 
+         *              the box size. The map is computed once in parallel 
+         *              and can be shared by the kernels working on objects 
+         *              of the same layout (see resolution_map). The squared
+         *              radii are kept in single precision to halve the 
+         *              memory traffic of these kernels.
+         */
+        template<size_t rank_>
+        class ResolutionMap {
+        public:
+            using index_type = element::Index<rank_>;
+            using cell_type = std::array<double, rank_>;
+            using radius_tensor = element::Tensor<float, rank_, element::StorageOrder::COLUMN_MAJOR>;
+            using shell_tensor = element::Tensor<int, rank_, element::StorageOrder::COLUMN_MAJOR>;
+            
+            /**
+             * @param logical_range: range of the real space object
+             * @param origin: origin of the complex half object
+             * @param cell: lengths of the unit cell (non-zero)
+             */
+            ResolutionMap(const index_type& logical_range, const index_type& origin, const cell_type& cell)
+            : logical_range_(logical_range), cell_(cell), shell_width_(0), num_shells_(0) {
+                index_type range = logical_range;
+                range[0] = range[0] / 2 + 1;
+                squared_radii_ = radius_tensor(range, origin);
+                shells_ = shell_tensor(range, origin);
+                
+                double longest = 0;
+                for (size_t i = 0; i < rank_; ++i) {
+                    if (cell[i] <= 0) std::cerr << "WARNING: Encountered non-positive cell length " << cell[i] << " in the resolution map.\n";
+                    longest = std::max(longest, cell[i]);
+                }
+                shell_width_ = longest > 0 ? 1.0 / longest : 1.0;
+                compute();
+            }
+            
+            const index_type& logical_range() const {
+                return logical_range_;
+            }
+            
+            const cell_type& cell() const {
+                return cell_;
+            }
+            
+            /**
+             * Number of elements, the size of the complex half objects
+             */
+            size_t size() const {
+                return squared_radii_.size();
+            }
+            
+            /**
+             * Squared reciprocal radii, d*^2, in the memory layout of the
+             * complex half objects
+             */
+            const radius_tensor& squared_radii() const {
+                return squared_radii_;
+            }
+            
+            /**
+             * Shell ids in the memory layout of the complex half objects
+             */
+            const shell_tensor& shells() const {
+                return shells_;
+            }
+            
+            /**
+             * Reciprocal radius, d*, of the element at the memory id
+             */
+            double radius(size_t id) const {
+                return std::sqrt((double) squared_radii_.data()[id]);
+            }
+            
+            int shell(size_t id) const {
+                return shells_.data()[id];
+            }
+            
+            /**
+             * Width of the shells in reciprocal length
+             */
+            double shell_width() const {
+                return shell_width_;
+            }
+            
+            /**
+             * Number of shells, i.e. the largest shell id + 1
+             */
+            size_t num_shells() const {
+                return num_shells_;
+            }
+            
+            /**
+             * Number of elements of the full Fourier space represented by
+             * the stored elements at the position x of the half axis: 2 
+             * for the elements having their Friedel mates in the missing
+             * half, 1 on the planes x = 0 and x = n/2 (even n).
+             */
+            int multiplicity(size_t x) const {
+                return (x == 0 || 2 * x == (size_t) logical_range_[0]) ? 1 : 2;
+            }
+            
+            /**
+             * Reciprocal radius at the center of the shell
+             */
+            double shell_radius(size_t shell) const {
+                return shell * shell_width_;
+            }
+            
+        private:
+            
+            /**
+             * Frequency of the physical position along an axis of the 
+             * given size, brought in [-size/2, size/2) for the centered
+             * axes and kept as is for the half axis.
+             */
+            static std::ptrdiff_t frequency(std::ptrdiff_t position, std::ptrdiff_t origin, std::ptrdiff_t size, bool half) {
+                std::ptrdiff_t value = position - origin;
+                if (half) return value;
+                value = ((value % size) + size) % size;
+                if (value >= size - size / 2) value -= size;
+                return value;
+            }
+            
+            /**
+             * The squared contributions of every axis are tabulated, the 
+             * rows along x are then filled in parallel.
+             */
+            void compute() {
+                const index_type range = squared_radii_.range();
+                const index_type origin = squared_radii_.origin();
+                const size_t total = range.size();
+                if (total == 0) return;
+                
+                std::array<std::vector<double>, rank_> axis_terms;
+                for (size_t i = 0; i < rank_; ++i) {
+                    axis_terms[i].resize(range[i]);
+                    for (std::ptrdiff_t p = 0; p < range[i]; ++p) {
+                        const double term = frequency(p, origin[i], logical_range_[i], i == 0) / cell_[i];
+                        axis_terms[i][p] = term * term;
+                    }
+                }
+                
+                const size_t length = range[0];
+                float* radii = squared_radii_.data();
+                int* shells = shells_.data();
+                const int max_shell = parallel::parallel_reduce_blocks(total / length, std::max<size_t>(1, parallel::block_size<float>() / length), 0,
+                    [&](size_t begin, size_t end) {
+                        int block_max = 0;
+                        for (size_t row = begin; row < end; ++row) {
+                            size_t remainder = row;
+                            double row_term = 0;
+                            for (size_t dim = 1; dim < rank_; ++dim) {
+                                row_term += axis_terms[dim][remainder % range[dim]];
+                                remainder /= range[dim];
+                            }
+                            for (size_t x = 0; x < length; ++x) {
+                                const double squared = row_term + axis_terms[0][x];
+                                const int shell = (int) std::round(std::sqrt(squared) / shell_width_);
+                                radii[row * length + x] = (float) squared;
+                                shells[row * length + x] = shell;
+                                block_max = std::max(block_max, shell);
+                            }
+                        }
+                        return block_max;
+                    },
+                    [](int current, int next) {
+                        return std::max(current, next);
+                    });
+                num_shells_ = max_shell + 1;
+            }
+            
+            index_type logical_range_;
+            cell_type cell_;
+            double shell_width_;
+            size_t num_shells_;
+            radius_tensor squared_radii_;
+            shell_tensor shells_;
+        };
+        
+        /**
+         * The process wide resolution map of a layout, created on the 
+         * first request. The maps are immutable and can be shared by 
+         * threads, e.g. by the filters applied in every iteration of a
+         * refinement. The cache only holds weak references: a map is 
+         * freed with its last user and built again on the next request.
+         * @param logical_range: range of the real space object
+         * @param origin: origin of the complex half object
+         * @param cell: lengths of the unit cell
+         */
+        template<size_t rank_>
+        std::shared_ptr<const ResolutionMap<rank_>> resolution_map(const element::Index<rank_>& logical_range,
+                const element::Index<rank_>& origin, const typename ResolutionMap<rank_>::cell_type& cell) {
+            std::vector<double> key;
+            for (size_t i = 0; i < rank_; ++i) {
+                key.push_back(logical_range[i]);
+                key.push_back(origin[i]);
+                key.push_back(cell[i]);
+            }
+            
+            static std::map<std::vector<double>, std::weak_ptr<const ResolutionMap<rank_>>> maps;
+            static std::mutex mutex;
+            std::lock_guard<std::mutex> lock(mutex);
+            auto found = maps.find(key);
+            if (found != maps.end()) {
+                if (auto map = found->second.lock()) return map;
+            }
+            
+            for (auto it = maps.begin(); it != maps.end();) {
+                if (it->second.expired()) it = maps.erase(it);
+                else ++it;
+            }
+            std::shared_ptr<const ResolutionMap<rank_>> map(new ResolutionMap<rank_>(logical_range, origin, cell));
+            maps[key] = map;
+            return map;
+        }
+        
+        /**
+         * The resolution map of a complex half object with its own cell
+         */
+        template<typename ObjectType_>
+        std::shared_ptr<const ResolutionMap<ObjectType_::rank>> resolution_map(const ObjectType_& object) {
+            const auto cell_lengths = object.cell_lengths();
+            typename ResolutionMap<ObjectType_::rank>::cell_type cell;
+            for (size_t i = 0; i < ObjectType_::rank; ++i) cell[i] = cell_lengths[i];
+            return resolution_map(object.logical_range(), object.origin(), cell);
+        }
+        
+        /**
+         * The resolution map of the images of a batch of transforms (see 
+         * fourier_transform_batch), the last axis being the image number
+         */
+        template<typename ObjectType_>
+        std::shared_ptr<const ResolutionMap<ObjectType_::rank - 1>> image_resolution_map(const ObjectType_& stack) {
+            const size_t image_rank = ObjectType_::rank - 1;
+            const auto logical_range = stack.logical_range();
+            const auto origin = stack.origin();
+            const auto cell_lengths = stack.cell_lengths();
+            assert(origin[image_rank] == 0);
+            
+            element::Index<image_rank> image_range, image_origin;
+            typename ResolutionMap<image_rank>::cell_type cell;
+            for (size_t i = 0; i < image_rank; ++i) {
+                image_range[i] = logical_range[i];
+                image_origin[i] = origin[i];
+                cell[i] = cell_lengths[i];
+            }
+            return resolution_map(image_range, image_origin, cell);
+        }
+        
+        /**
+         * Number of shells of the map reported for a requested number,
+         * all the shells for 0
+         */
+        template<size_t rank_>
+        size_t reported_shells(const ResolutionMap<rank_>& map, size_t shells) {
+            return shells == 0 ? map.num_shells() : std::min(shells, map.num_shells());
+        }
+        
+    }
+}
+
+#endif /* RESOLUTION_MAP_HPP */
@@ -0,0 +1,121 @@
+/* 
+ * This file is a part of emkit.
+ * 
+ * emkit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * emkit is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>
+ * 
+ * Author:
+ * Nikhil Biyani: nikhil(dot)biyani(at)gmail(dot)com
+ * 
+ */
+
+#ifndef EM_ALIGNED_ALLOCATOR_HPP
+#define EM_ALIGNED_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <limits>
+
+#include "arena.hpp"
+
+namespace em {
+    namespace element {
+
+        /**
+         * @brief       STL allocator providing memory aligned to the given
+         *              number of bytes.
+         * @description The default alignment of 64 bytes is a cache line and
+         *              satisfies the requirements of all the SIMD instruction
+         *              sets (SSE, AVX, AVX-512). It is also at least the
+         *              alignment used by fftw_malloc, so that FFTW plans
+         *              created on fftw_malloc'ed arrays can be executed
+         *              directly on the memory allocated here.
+         *              
+         *              While an ArenaScope is active on the calling thread,
+         *              the memory is taken from the arena of the thread
+         *              (or from the heap if the arena is pinned and full).
+         *              Every block is preceded by a header of alignment 
+         *              bytes telling if it belongs to an arena, so that the
+         *              blocks can be freed anywhere.
+         */
+        template<typename ValueType_, size_t alignment_ = 64>
+        class AlignedAllocator {
+        public:
+            static const size_t alignment = alignment_;
+
+            using value_type = ValueType_;
+            using pointer = ValueType_*;
+            using const_pointer = const ValueType_*;
+            using reference = ValueType_&;
+            using const_reference = const ValueType_&;
+            using size_type = std::size_t;
+            using difference_type = std::ptrdiff_t;
+
+            template<typename OtherType_>
+            struct rebind {
+                using other = AlignedAllocator<OtherType_, alignment_>;
+            };
+
+            static_assert(alignment_ >= alignof(void*) && (alignment_ & (alignment_ - 1)) == 0,
+                    "The alignment should be a power of two and a multiple of the pointer size");
+
+            AlignedAllocator() = default;
+
+            template<typename OtherType_>
+            AlignedAllocator(const AlignedAllocator<OtherType_, alignment_>&) {
+            };
+
+            pointer allocate(size_type n) {
+                if (n > max_size()) throw std::bad_alloc();
+                const size_type bytes = (n > 0 ? n : 1) * sizeof (value_type);
+                
+                Arena* arena = Arena::current();
+                if (arena != nullptr) {
+                    void* block = arena->allocate(bytes, alignment_);
+                    if (block != nullptr) return static_cast<pointer> (block);
+                }
+                
+                void* memory = nullptr;
+                if (posix_memalign(&memory, alignment_, bytes + alignment_) != 0) {
+                    throw std::bad_alloc();
+                }
+                void* block = static_cast<char*> (memory) + alignment_;
+                Arena::owner(block) = nullptr;
+                return static_cast<pointer> (block);
+            }
+
+            void deallocate(pointer p, size_type) {
+                Arena* arena = Arena::owner(p);
+                if (arena != nullptr) arena->release(p);
+                else std::free(reinterpret_cast<char*> (p) - alignment_);
+            }
+
+            size_type max_size() const {
+                return (std::numeric_limits<size_type>::max() - alignment_) / sizeof (value_type);
+            }
+
+        };
+
+        template<typename Type1_, typename Type2_, size_t alignment_>
+        bool operator==(const AlignedAllocator<Type1_, alignment_>&, const AlignedAllocator<Type2_, alignment_>&) {
+            return true;
+        }
+
+        template<typename Type1_, typename Type2_, size_t alignment_>
+        bool operator!=(const AlignedAllocator<Type1_, alignment_>&, const AlignedAllocator<Type2_, alignment_>&) {
+            return false;
+        }
+
+    }
+}
+
+#endif /* EM_ALIGNED_ALLOCATOR_HPP */
+
@@ -0,0 +1,270 @@
+/* 
+ * This file is a part of emkit.
+ * 
+ * emkit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * emkit is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>
+ * 
+ * Author:
+ * Nikhil Biyani: nikhil(dot)biyani(at)gmail(dot)com
+ * 
+ */
+
+#ifndef EM_ARENA_HPP
+#define EM_ARENA_HPP
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+
+namespace em {
+    namespace element {
+
+        /**
+         * @brief       A thread-local region of memory for short-lived
+         *              allocations
+         * @description The memory is handed out from large chunks by moving
+         *              a pointer, without locks or calls to malloc. Freeing
+         *              only counts down the allocations alive, the memory is
+         *              reused all at once when the arena is reset with no
+         *              allocation alive (e.g. at the end of a work item, see
+         *              ArenaScope). If the arena needed several chunks, they
+         *              are merged in one at the reset.
+         *              
+         *              A reset failing because of a block still alive pins
+         *              the arena: it then only fills the chunks it already
+         *              has and allocate() returns nullptr instead of adding
+         *              new ones, until a reset succeeds again. The memory 
+         *              held by the arena is so bounded even if some blocks
+         *              outlive their work item.
+         *              
+         *              Every block is preceded by a header holding the arena
+         *              that owns it, so that the blocks can be freed from 
+         *              any thread and after the arena was left.
+         *              The allocations are done by the owning thread only.
+         */
+        class Arena {
+        public:
+
+            /**
+             * Size of the first chunk in bytes
+             */
+            static const size_t kChunkBytes = 8 * 1024 * 1024;
+
+            /**
+             * The arena of the calling thread
+             */
+            static Arena& local() {
+                thread_local Holder holder;
+                return *holder.arena;
+            }
+
+            /**
+             * The arena the calling thread allocates from at the moment, 
+             * nullptr if none is used.
+             */
+            static Arena*& current() {
+                thread_local Arena* current_arena = nullptr;
+                return current_arena;
+            }
+
+            /**
+             * Owner stored in the header of a block (nullptr for the blocks
+             * which are not in an arena)
+             */
+            static Arena*& owner(void* block) {
+                return *(static_cast<Arena**> (block) - 1);
+            }
+
+            Arena(size_t chunk_bytes = kChunkBytes)
+            : chunk_bytes_(chunk_bytes), current_chunk_(0), live_(0), pinned_(false), orphaned_(false) {
+            }
+
+            ~Arena() {
+                for (auto& chunk : chunks_) std::free(chunk.memory);
+            }
+
+            Arena(const Arena&) = delete;
+
+            Arena& operator=(const Arena&) = delete;
+
+            /**
+             * Allocates bytes aligned to the alignment, which is a power of
+             * two at least the size of a pointer. The block is preceded
+             * by a header of alignment bytes holding the owner.
+             * @return the block, nullptr if the arena is pinned and has no
+             * room left for it
+             */
+            void* allocate(size_t bytes, size_t alignment) {
+                const size_t needed = bytes + 2 * alignment;
+                while (current_chunk_ < chunks_.size() && chunks_[current_chunk_].free() < needed) ++current_chunk_;
+                if (current_chunk_ == chunks_.size()) {
+                    if (pinned_) return nullptr;
+                    add_chunk(needed);
+                }
+
+                Chunk& chunk = chunks_[current_chunk_];
+                std::uintptr_t start = reinterpret_cast<std::uintptr_t> (chunk.memory + chunk.used);
+                start = (start + alignment - 1) & ~(std::uintptr_t) (alignment - 1);
+                char* block = reinterpret_cast<char*> (start) + alignment;
+                chunk.used = (block + bytes) - chunk.memory;
+
+                owner(block) = this;
+                ++live_;
+                return block;
+            }
+
+            /**
+             * Marks a block of the arena as freed, can be called from any
+             * thread. The last block of an arena whose thread has ended
+             * deletes the arena.
+             */
+            void release(void*) {
+                if (--live_ == 0 && orphaned_) delete this;
+            }
+
+            /**
+             * Makes all the memory available again if no allocation is
+             * alive, otherwise pins the arena until the next reset that
+             * succeeds.
+             * @return true if the memory was reset
+             */
+            bool reset() {
+                if (live_ != 0) {
+                    pinned_ = true;
+                    return false;
+                }
+                pinned_ = false;
+                if (chunks_.size() > 1) {
+                    size_t total = 0;
+                    for (auto& chunk : chunks_) {
+                        total += chunk.size;
+                        std::free(chunk.memory);
+                    }
+                    chunks_.clear();
+                    add_chunk(total);
+                }
+                for (auto& chunk : chunks_) chunk.used = 0;
+                current_chunk_ = 0;
+                return true;
+            }
+
+            /**
+             * Number of allocations alive
+             */
+            size_t live() const {
+                return live_;
+            }
+
+            /**
+             * True if a reset failed since the last one that succeeded
+             */
+            bool pinned() const {
+                return pinned_;
+            }
+
+            /**
+             * Number of bytes held by the arena
+             */
+            size_t capacity() const {
+                size_t total = 0;
+                for (const auto& chunk : chunks_) total += chunk.size;
+                return total;
+            }
+
+        private:
+
+            struct Chunk {
+                char* memory;
+                size_t size;
+                size_t used;
+
+                size_t free() const {
+                    return size - used;
+                }
+            };
+
+            /**
+             * Owns the arena of a thread. If allocations are still alive
+             * when the thread ends, the arena is left to them and the last
+             * one released deletes it.
+             */
+            struct Holder {
+                Arena* arena = new Arena();
+
+                ~Holder() {
+                    // The holder counts as an allocation while orphaning, so
+                    // that only one of the releases sees the count reach 0.
+                    ++arena->live_;
+                    arena->orphaned_ = true;
+                    arena->release(nullptr);
+                }
+            };
+
+            void add_chunk(size_t needed) {
+                Chunk chunk;
+                chunk.size = std::max(needed, chunks_.empty() ? chunk_bytes_ : 2 * chunks_.back().size);
+                chunk.used = 0;
+                void* memory = nullptr;
+                if (posix_memalign(&memory, 64, chunk.size) != 0) throw std::bad_alloc();
+                chunk.memory = static_cast<char*> (memory);
+                chunks_.push_back(chunk);
+            }
+
+            size_t chunk_bytes_;
+            std::vector<Chunk> chunks_;
+            size_t current_chunk_;
+            std::atomic<size_t> live_;
+            bool pinned_;
+            std::atomic<bool> orphaned_;
+        };
+
+        /**
+         * @brief       Makes the allocations of the calling thread use its
+         *              arena while the scope exists
+         * @description Used around a work item (e.g. one particle of a 
+         *              stack): all the tensors and FFT buffers created in
+         *              the scope take their memory from the arena of the
+         *              thread. The arena is reset when the outermost scope
+         *              is left, so the objects created in the scope should 
+         *              not outlive it (they are still valid if they do, but
+         *              the arena is then pinned and the allocations it has
+         *              no room for go to the heap until it can be reset).
+         *              Scopes can be nested.
+         */
+        class ArenaScope {
+        public:
+
+            ArenaScope()
+            : previous_(Arena::current()) {
+                Arena::current() = &Arena::local();
+            }
+
+            ~ArenaScope() {
+                Arena::current() = previous_;
+                if (previous_ != &Arena::local()) Arena::local().reset();
+            }
+
+            ArenaScope(const ArenaScope&) = delete;
+
+            ArenaScope& operator=(const ArenaScope&) = delete;
+
+        private:
+            Arena* previous_;
+        };
+
+    }
+}
+
+#endif /* EM_ARENA_HPP */
+
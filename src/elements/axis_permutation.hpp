@@ -0,0 +1,180 @@
+/* 
+ * This file is a part of emkit.
+ * 
+ * emkit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * emkit is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>
+ * 
+ * Author:
+ * Nikhil Biyani: nikhil(dot)biyani(at)gmail(dot)com
+ * 
+ */
+
+#ifndef EM_MULTIDIM_AXIS_PERMUTATION_HPP
+#define EM_MULTIDIM_AXIS_PERMUTATION_HPP
+
+#include <cstddef>
+#include <cassert>
+#include <algorithm>
+
+#include "tensor_storage_order.hpp"
+#include "../parallel/parallel_algorithm.hpp"
+
+namespace em {
+    namespace element {
+
+        namespace permutation_impl {
+
+            /**
+             * Edge of the square tiles used for the transposition. A tile of
+             * the input and one of the output fit together in the L1 cache.
+             */
+            template<typename DataType_>
+            size_t tile_size() {
+                size_t tile = 8;
+                while (2 * tile * 2 * tile * sizeof (DataType_) <= 16 * 1024) tile *= 2;
+                return tile;
+            }
+
+        }
+
+        /**
+         * Checks if the indices are a permutation of (0, 1, ..., rank-1)
+         */
+        template<size_t rank_>
+        bool is_permutation(const Index<rank_>& permutation) {
+            bool found[rank_] = {};
+            for (size_t i = 0; i < rank_; ++i) {
+                if (permutation[i] < 0 || permutation[i] >= (std::ptrdiff_t) rank_ || found[permutation[i]]) return false;
+                found[permutation[i]] = true;
+            }
+            return true;
+        }
+
+        /**
+         * Range of the tensor after permuting the axes of the given range
+         */
+        template<size_t rank_>
+        Index<rank_> permuted_range(const Index<rank_>& range, const Index<rank_>& permutation) {
+            Index<rank_> permuted;
+            for (size_t i = 0; i < rank_; ++i) permuted[i] = range[permutation[i]];
+            return permuted;
+        }
+
+        /**
+         * @brief       Copies the memory of a tensor permuting its axes and
+         *              changing its storage order, i.e. the element at the
+         *              physical index p of the input is written at q with
+         *              q[i] = p[permutation[i]] in the output.
+         * @description The copy is done in square tiles spanning the fastest
+         *              dimension of the input and the fastest dimension of
+         *              the output, so that both the reads and the writes run
+         *              over contiguous memory. The tiles are sized to stay in
+         *              L1, a task handles a band of tiles of about the size
+         *              of L2 and the tasks run in parallel. If both the
+         *              fastest dimensions are the same, the rows are copied
+         *              directly.
+         * @param       input: memory of the input tensor stored with in_order_
+         * @param       range: range of the input
+         * @param       output: memory of the output stored with out_order_,
+         *              not overlapping the input
+         * @param       permutation: axis of the input for every axis of the output
+         */
+        template<StorageOrder in_order_, StorageOrder out_order_, typename DataType_, size_t rank_>
+        void permute_axes(const DataType_* input, const Index<rank_>& range, DataType_* output, const Index<rank_>& permutation) {
+            assert(is_permutation(permutation));
+            const size_t total = range.size();
+            if (total == 0) return;
+
+            //Strides of both the memories for every axis of the input
+            const Index<rank_> in_stride = MemoryArranger<rank_, in_order_>::get_stride(range);
+            const Index<rank_> out_permuted_stride = MemoryArranger<rank_, out_order_>::get_stride(permuted_range(range, permutation));
+            Index<rank_> out_stride;
+            for (size_t i = 0; i < rank_; ++i) out_stride[permutation[i]] = out_permuted_stride[i];
+
+            const size_t in_fastest = MemoryArranger<rank_, in_order_>::dimension(0);
+            const size_t out_fastest = permutation[MemoryArranger<rank_, out_order_>::dimension(0)];
+
+            //The remaining dimensions are iterated as an outer range
+            size_t outer_dims[rank_];
+            size_t num_outer = 0;
+            for (size_t dim = 0; dim < rank_; ++dim) {
+                if (dim != in_fastest && dim != out_fastest) outer_dims[num_outer++] = dim;
+            }
+
+            auto outer_offsets = [&](size_t outer, size_t& in_offset, size_t& out_offset) {
+                in_offset = 0;
+                out_offset = 0;
+                for (size_t n = 0; n < num_outer; ++n) {
+                    const size_t dim = outer_dims[n];
+                    const size_t position = outer % range[dim];
+                    outer /= range[dim];
+                    in_offset += position * in_stride[dim];
+                    out_offset += position * out_stride[dim];
+                }
+            };
+
+            if (in_fastest == out_fastest) {
+                const size_t length = range[in_fastest];
+                parallel::parallel_for(total / length, std::max<size_t>(1, parallel::block_size<DataType_>() / length), [&](size_t begin, size_t end) {
+                    for (size_t row = begin; row < end; ++row) {
+                        size_t in_offset, out_offset;
+                        outer_offsets(row, in_offset, out_offset);
+                        std::copy(input + in_offset, input + in_offset + length, output + out_offset);
+                    }
+                });
+                return;
+            }
+
+            const size_t columns = range[in_fastest];
+            const size_t rows = range[out_fastest];
+            const size_t in_row_stride = in_stride[out_fastest];
+            const size_t out_column_stride = out_stride[in_fastest];
+            const size_t tile = permutation_impl::tile_size<DataType_>();
+            const size_t bands = (rows + tile - 1) / tile;
+            const size_t outer_size = total / (rows * columns);
+
+            //A task transposes a band of tile rows over all the columns
+            parallel::parallel_for(outer_size * bands, std::max<size_t>(1, parallel::block_size<DataType_>() / (tile * columns)), [&](size_t begin, size_t end) {
+                for (size_t task = begin; task < end; ++task) {
+                    size_t in_offset, out_offset;
+                    outer_offsets(task / bands, in_offset, out_offset);
+                    const size_t row_begin = (task % bands) * tile;
+                    const size_t row_end = std::min(rows, row_begin + tile);
+
+                    for (size_t column_begin = 0; column_begin < columns; column_begin += tile) {
+                        const size_t column_end = std::min(columns, column_begin + tile);
+                        for (size_t column = column_begin; column < column_end; ++column) {
+                            const DataType_* source = input + in_offset + column;
+                            DataType_* target = output + out_offset + column * out_column_stride;
+                            for (size_t row = row_begin; row < row_end; ++row) {
+                                target[row] = source[row * in_row_stride];
+                            }
+                        }
+                    }
+                }
+            });
+        }
+
+        /**
+         * Copies the memory of a tensor to the memory of the same tensor
+         * stored in a different storage order.
+         */
+        template<StorageOrder in_order_, StorageOrder out_order_, typename DataType_, size_t rank_>
+        void change_storage_order(const DataType_* input, const Index<rank_>& range, DataType_* output) {
+            Index<rank_> identity;
+            for (size_t i = 0; i < rank_; ++i) identity[i] = i;
+            permute_axes<in_order_, out_order_>(input, range, output, identity);
+        }
+
+    }
+}
+
+#endif /* EM_MULTIDIM_AXIS_PERMUTATION_HPP */
+
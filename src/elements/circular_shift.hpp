@@ -0,0 +1,162 @@
+/* 
+ * This file is a part of emkit.
+ * 
+ * emkit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * emkit is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>
+ * 
+ * Author:
+ * Nikhil Biyani: nikhil(dot)biyani(at)gmail(dot)com
+ * 
+ */
+
+#ifndef EM_MULTIDIM_CIRCULAR_SHIFT_HPP
+#define EM_MULTIDIM_CIRCULAR_SHIFT_HPP
+
+#include <cstddef>
+#include <cassert>
+#include <vector>
+#include <algorithm>
+
+#include "tensor_storage_order.hpp"
+#include "../parallel/parallel_algorithm.hpp"
+
+namespace em {
+    namespace element {
+
+        namespace shift_impl {
+
+            /**
+             * Brings the shift in [0, extent)
+             */
+            inline size_t positive_shift(std::ptrdiff_t shift, std::ptrdiff_t extent) {
+                return (size_t) (((shift % extent) + extent) % extent);
+            }
+
+        }
+
+        /**
+         * @brief       Circularly shifts the elements stored in the memory in
+         *              place, i.e. the element at the position p moves to
+         *              (p + shift) mod range. Works for even and odd extents
+         *              and is used for fftshift like origin changes.
+         * @description The dimensions are shifted one after the other. The
+         *              memory of a dimension is a sequence of segments each
+         *              holding range[dim] consecutive blocks of stride[dim]
+         *              elements, the shift moves the blocks in the segment.
+         *              The fastest dimension is rotated row by row, other
+         *              dimensions are moved column-block wise through a
+         *              small buffer so that all the copies are contiguous.
+         *              The segments and column blocks are processed in
+         *              parallel. Dimensions with no shift are skipped.
+         * @param       data: memory of a tensor with the given range
+         * @param       range
+         * @param       shift: shift in every dimension (can be negative)
+         */
+        template<StorageOrder order_, typename DataType_, size_t rank_>
+        void circular_shift(DataType_* data, const Index<rank_>& range, const Index<rank_>& shift) {
+            using arranger_type = MemoryArranger<rank_, order_>;
+            const Index<rank_> stride = arranger_type::get_stride(range);
+            const size_t total = range.size();
+            const size_t block = parallel::block_size<DataType_>();
+
+            for (size_t n = 0; n < rank_; ++n) {
+                const size_t dim = arranger_type::dimension(n);
+                const size_t extent = range[dim];
+                if (extent <= 1) continue;
+                const size_t distance = shift_impl::positive_shift(shift[dim], extent);
+                if (distance == 0) continue;
+
+                const size_t inner = stride[dim];
+                const size_t segment = inner * extent;
+                const size_t segments = total / segment;
+
+                if (inner == 1) {
+                    //Contiguous rows, rotate each of them
+                    parallel::parallel_for(segments, std::max<size_t>(1, block / segment), [&](size_t begin, size_t end) {
+                        for (size_t s = begin; s < end; ++s) {
+                            DataType_* row = data + s * segment;
+                            std::rotate(row, row + extent - distance, row + extent);
+                        }
+                    });
+                } else {
+                    //Move blocks of columns through a buffer
+                    const size_t width = std::min(inner, std::max<size_t>(1, block / extent));
+                    const size_t columns = (inner + width - 1) / width;
+                    parallel::parallel_for(segments * columns, std::max<size_t>(1, block / (width * extent)), [&](size_t begin, size_t end) {
+                        std::vector<DataType_> buffer(width * extent);
+                        for (size_t task = begin; task < end; ++task) {
+                            DataType_* first = data + (task / columns) * segment + (task % columns) * width;
+                            const size_t length = std::min(width, inner - (task % columns) * width);
+                            for (size_t j = 0; j < extent; ++j) {
+                                std::copy(first + j * inner, first + j * inner + length, buffer.begin() + j * length);
+                            }
+                            for (size_t j = 0; j < extent; ++j) {
+                                size_t target = j + distance;
+                                if (target >= extent) target -= extent;
+                                std::copy(buffer.begin() + j * length, buffer.begin() + (j + 1) * length, first + target * inner);
+                            }
+                        }
+                    });
+                }
+            }
+        }
+
+        /**
+         * @brief       Circularly shifted copy of the memory, i.e. the element
+         *              at the position p of the input is written at
+         *              (p + shift) mod range of the output.
+         * @description Every row along the fastest dimension is copied with
+         *              two contiguous copies to its shifted row. The rows are
+         *              processed in parallel.
+         * @param       input: memory of a tensor with the given range
+         * @param       output: memory of the same size not overlapping input
+         * @param       range
+         * @param       shift: shift in every dimension (can be negative)
+         */
+        template<StorageOrder order_, typename DataType_, size_t rank_>
+        void circular_shift(const DataType_* input, DataType_* output, const Index<rank_>& range, const Index<rank_>& shift) {
+            using arranger_type = MemoryArranger<rank_, order_>;
+            const Index<rank_> stride = arranger_type::get_stride(range);
+            const size_t total = range.size();
+            if (total == 0) return;
+
+            Index<rank_> distance;
+            for (size_t dim = 0; dim < rank_; ++dim) distance[dim] = shift_impl::positive_shift(shift[dim], range[dim]);
+
+            const size_t fastest = arranger_type::dimension(0);
+            const size_t length = range[fastest];
+            const size_t split = length - distance[fastest];
+
+            parallel::parallel_for(total / length, std::max<size_t>(1, parallel::block_size<DataType_>() / length), [&](size_t begin, size_t end) {
+                for (size_t row = begin; row < end; ++row) {
+                    //Position of the shifted row
+                    size_t remainder = row * length;
+                    size_t target = 0;
+                    for (size_t n = rank_ - 1; n > 0; --n) {
+                        const size_t dim = arranger_type::dimension(n);
+                        size_t position = remainder / stride[dim];
+                        remainder -= position * stride[dim];
+                        position += distance[dim];
+                        if (position >= (size_t) range[dim]) position -= range[dim];
+                        target += position * stride[dim];
+                    }
+
+                    const DataType_* source = input + row * length;
+                    std::copy(source, source + split, output + target + distance[fastest]);
+                    std::copy(source + split, source + length, output + target);
+                }
+            });
+        }
+
+    }
+}
+
+#endif /* EM_MULTIDIM_CIRCULAR_SHIFT_HPP */
+
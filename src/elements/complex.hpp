@@ -21,6 +21,7 @@
 
 #include <iostream>
 #include <complex>
+#include <type_traits>
 
 namespace em {
     
@@ -78,6 +79,24 @@ namespace em {
                 return Complex(real() + rhs.real(), imag() + rhs.imag());
             };
 
+            /**
+             * Operator overloading of - operator.
+             * Subtracts the real and imag part of rhs from this object.
+             * @param rhs
+             * @return difference
+             */
+            Complex operator-(const Complex& rhs) const {
+                return Complex(real() - rhs.real(), imag() - rhs.imag());
+            };
+
+            /**
+             * Negates the real and imag part
+             * @return negated complex
+             */
+            Complex operator-() const {
+                return Complex(-real(), -imag());
+            };
+
             /**
              * Declaration of multiplication of a double with complex2dx
              * @param factor
@@ -95,6 +114,17 @@ namespace em {
                 return *this;
             };
 
+            /**
+             * Declaration of division of a complex by a double
+             * @param factor
+             * @return 
+             */
+            template<typename ArithmeticType_>
+            Complex operator/(ArithmeticType_ factor) const {
+                static_assert(std::is_arithmetic<ArithmeticType_>::value, "The rhs should be of arithmetic type.");
+                return Complex(real() / factor, imag() / factor);
+            };
+
             /**
              * Declaration of multiplication of a Complex with another Complex
              * @param another complex
@@ -127,6 +157,7 @@ namespace em {
 
             friend inline std::ostream& operator<<(std::ostream& os, const Complex& obj) {
                 os << " " << obj.real() << " + " << obj.imag() << "i ";
+                return os;
             }
 
             /**
@@ -212,6 +243,15 @@ namespace em {
 
 
         };
+        
+        /**
+         * Multiplication of a double with a complex
+         */
+        template<typename ArithmeticType_, typename ValueType_>
+        typename std::enable_if<std::is_arithmetic<ArithmeticType_>::value, Complex<ValueType_>>::type
+        operator*(ArithmeticType_ factor, const Complex<ValueType_>& complex) {
+            return complex * factor;
+        }
     }
 }
 
@@ -22,7 +22,7 @@ namespace em {
             
             IndexValuePair() {};
             
-            IndexValuePair(Index<rank_>& idx, ValueType_* val)
+            IndexValuePair(const Index<rank_>& idx, ValueType_* val)
             : index_(idx), value_(val) {
             };
             
@@ -0,0 +1,143 @@
+/* 
+ * This file is a part of emkit.
+ * 
+ * emkit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * emkit is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>
+ * 
+ * Author:
+ * Nikhil Biyani: nikhil(dot)biyani(at)gmail(dot)com
+ * 
+ */
+
+#ifndef EM_MAPPED_FILE_HPP
+#define EM_MAPPED_FILE_HPP
+
+#include <string>
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace em {
+    namespace element {
+
+        /**
+         * @brief       A region of a file mapped in memory
+         * @description The pages of the region are read from the file on
+         *              the first access and are shared through the page
+         *              cache with all the processes mapping the same file,
+         *              so that files larger than the memory can be used.
+         *              
+         *              The region is either read-only or copy-on-write. In
+         *              the latter the pages written are copied privately and
+         *              the file is never changed. The copy-on-write regions
+         *              are mapped without reserving swap for the copies 
+         *              (MAP_NORESERVE where available), as otherwise the
+         *              kernel refuses regions larger than the memory.
+         *              The region is unmapped when the object is destroyed.
+         */
+        class MappedFile {
+        public:
+
+            enum class Access {
+                READ_ONLY, COPY_ON_WRITE
+            };
+
+            /**
+             * Maps the given number of bytes of the file starting at the
+             * offset. Throws std::runtime_error if the file can not be
+             * mapped or is too short.
+             */
+            MappedFile(const std::string& file_name, size_t offset, size_t length, Access access = Access::READ_ONLY)
+            : address_(nullptr), mapped_length_(0), data_(nullptr), length_(length), access_(access) {
+                if (length == 0) throw std::runtime_error("Can not map an empty region of file: " + file_name);
+
+                int descriptor = ::open(file_name.c_str(), O_RDONLY);
+                if (descriptor < 0) throw std::runtime_error("Unable to open file: '" + file_name + "' " + std::strerror(errno));
+
+                struct stat status;
+                if (::fstat(descriptor, &status) != 0 || (size_t) status.st_size < offset + length) {
+                    ::close(descriptor);
+                    throw std::runtime_error("The file is shorter than the region to be mapped: " + file_name);
+                }
+
+                //The mapping has to start at a page boundary
+                const size_t page = (size_t) ::sysconf(_SC_PAGESIZE);
+                const size_t page_offset = offset % page;
+                mapped_length_ = length + page_offset;
+                int protection = PROT_READ;
+                int flags = MAP_PRIVATE;
+                if (access == Access::COPY_ON_WRITE) {
+                    protection |= PROT_WRITE;
+#ifdef MAP_NORESERVE
+                    flags |= MAP_NORESERVE;
+#endif
+                }
+                void* address = ::mmap(nullptr, mapped_length_, protection, flags, descriptor, (off_t) (offset - page_offset));
+                const int error = errno;
+                ::close(descriptor);
+                if (address == MAP_FAILED) throw std::runtime_error("Unable to map file: '" + file_name + "' " + std::strerror(error));
+
+                address_ = address;
+                data_ = static_cast<char*> (address) + page_offset;
+            }
+
+            ~MappedFile() {
+                if (address_ != nullptr) ::munmap(address_, mapped_length_);
+            }
+
+            MappedFile(const MappedFile&) = delete;
+
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            /**
+             * First byte of the region
+             */
+            char* data() {
+                return data_;
+            }
+
+            const char* data() const {
+                return data_;
+            }
+
+            /**
+             * Number of bytes in the region
+             */
+            size_t size() const {
+                return length_;
+            }
+
+            Access access() const {
+                return access_;
+            }
+
+            bool is_writable() const {
+                return access_ == Access::COPY_ON_WRITE;
+            }
+
+        private:
+            void* address_;
+            size_t mapped_length_;
+            char* data_;
+            size_t length_;
+            Access access_;
+        };
+
+    }
+}
+
+#endif /* EM_MAPPED_FILE_HPP */
+
@@ -26,41 +26,81 @@
 #include <vector>
 #include <algorithm>
 #include <functional>
+#include <memory>
+#include <stdexcept>
 
+#include "aligned_allocator.hpp"
 #include "tensor_storage_order.hpp"
+#include "tensor_view.hpp"
+#include "tensor_expression.hpp"
+#include "circular_shift.hpp"
+#include "axis_permutation.hpp"
 #include "index_value_pair.hpp"
+#include "../parallel/parallel_algorithm.hpp"
 
 
 namespace em {
     namespace element {
 
-        template<typename DataType_, size_t rank_, StorageOrder order_, bool is_const_iterator_>
+        template<typename ContainerType_, bool is_const_iterator_>
         class TensorIterator;
         
-        template<typename DataType_, size_t rank_, StorageOrder order_>
-        class Tensor {
+        /**
+         * @brief       A multidimensional array of a given rank and storage order
+         * @description The data is stored contiguously in a std::vector using
+         *              the allocator policy Allocator_. The default allocator 
+         *              aligns the memory to 64 bytes, so that the data can be 
+         *              passed directly to FFTW and to vectorized kernels, and
+         *              takes it from the arena of the thread inside an 
+         *              ArenaScope.
+         *              
+         *              Copies are deep, moves only pass the memory along. A
+         *              tensor can explicitly share its memory with share(),
+         *              the memory is then copied on the first write access
+         *              (non-const data(), operator[], iterators, views, 
+         *              modifiers) to one of the sharing tensors.
+         *              
+         *              A tensor can also be created on memory owned by
+         *              another object, e.g. a memory mapped file. The
+         *              memory is used as long as it is writable and not
+         *              shared, read-only memory is copied on the first
+         *              write access.
+         *              
+         *              Arithmetic on tensors builds lazy expressions (see 
+         *              TensorExpression) which are evaluated in a single loop
+         *              when assigned to a tensor.
+         */
+        template<typename DataType_, size_t rank_, StorageOrder order_, typename Allocator_ = AlignedAllocator<DataType_>>
+        class Tensor : public TensorExpression<Tensor<DataType_, rank_, order_, Allocator_>> {
         public:
             static const int rank = rank_;
             static const StorageOrder storage_order = order_;
             using index_type = Index<rank_>;
             using data_type = DataType_;
             using arranger_type = MemoryArranger<rank_, order_>;
+            using allocator_type = Allocator_;
 
             //For STL Random Access Iterator
             using value_type = IndexValuePair<DataType_, rank_>;
-            using iterator = TensorIterator<DataType_, rank_, order_, false>;
-            using const_iterator = TensorIterator<DataType_, rank_, order_, true>;
+            using iterator = TensorIterator<Tensor<DataType_, rank_, order_, Allocator_>, false>;
+            using const_iterator = TensorIterator<Tensor<DataType_, rank_, order_, Allocator_>, true>;
+            using view_type = TensorView<DataType_, rank_, order_>;
+            using const_view_type = TensorView<const DataType_, rank_, order_>;
             using reference = DataType_&;
             using const_reference = const DataType_&;
             using pointer = typename std::add_pointer<DataType_>::type;
+            using const_pointer = typename std::add_pointer<const DataType_>::type;
             using difference_type = std::ptrdiff_t;
             using size_type = typename Index<rank_>::size_type;
             using reverse_iterator = std::reverse_iterator<iterator>;
             using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
         private:
-            using SelfType_ = Tensor<DataType_, rank_, order_>;
-            using RepType_ = std::vector<DataType_>;
+            using SelfType_ = Tensor<DataType_, rank_, order_, Allocator_>;
+            using RepType_ = std::vector<DataType_, Allocator_>;
+            
+            template<typename, size_t, StorageOrder, typename>
+            friend class Tensor;
         
         public:
             /**
@@ -68,39 +108,115 @@ namespace em {
              */
 
             Tensor()
-            : range_(), origin_(0), data_container_() {
+            : range_(0), origin_(0), stride_(arranger_type::get_stride(range_)), data_container_() {
             };
             
             Tensor(const index_type& range, const data_type& default_value = DataType_())
-            : range_(range), origin_(0), data_container_(RepType_(range.size(), default_value)) {
+            : range_(range), origin_(0), stride_(arranger_type::get_stride(range)), data_container_(make_container(range.size(), default_value)) {
             }
             
             Tensor(const index_type& range, const index_type& origin, const data_type& default_value = DataType_())
-            : range_(range), origin_(origin), data_container_(RepType_(range.size(), default_value)) {
+            : range_(range), origin_(origin), stride_(arranger_type::get_stride(range)), data_container_(make_container(range.size(), default_value)) {
                 assert(range.contains(origin));
             }
 
             Tensor(const index_type& range, const RepType_& data) 
-            : range_(range), origin_(0), data_container_(data) {
+            : range_(range), origin_(0), stride_(arranger_type::get_stride(range)), data_container_(make_container(data)) {
                 assert(range.size() == data.size());
             };
             
+            /**
+             * Creates a tensor taking over the memory of the vector
+             */
+            Tensor(const index_type& range, RepType_&& data) 
+            : range_(range), origin_(0), stride_(arranger_type::get_stride(range)), data_container_(make_container(std::move(data))) {
+                assert(range.size() == data_container_->size());
+            };
+            
             Tensor(const index_type& range, const index_type& origin, const RepType_& data) 
-            : range_(range), origin_(origin), data_container_(data) {
+            : range_(range), origin_(origin), stride_(arranger_type::get_stride(range)), data_container_(make_container(data)) {
+                assert(range.size() == data.size());
+                assert(range.contains(origin));
+            };
+            
+            Tensor(const index_type& range, const index_type& origin, RepType_&& data) 
+            : range_(range), origin_(origin), stride_(arranger_type::get_stride(range)), data_container_(make_container(std::move(data))) {
+                assert(range.size() == data_container_->size());
+                assert(range.contains(origin));
+            };
+            
+            /**
+             * Creates a tensor copying the data from a vector using a 
+             * different allocator (e.g. a plain std::vector) or holding
+             * values convertible to the data type
+             */
+            template<typename OtherType_, typename OtherAllocator_>
+            Tensor(const index_type& range, const std::vector<OtherType_, OtherAllocator_>& data) 
+            : range_(range), origin_(0), stride_(arranger_type::get_stride(range)), data_container_(make_container(data.begin(), data.end())) {
+                assert(range.size() == data.size());
+            };
+            
+            template<typename OtherType_, typename OtherAllocator_>
+            Tensor(const index_type& range, const index_type& origin, const std::vector<OtherType_, OtherAllocator_>& data) 
+            : range_(range), origin_(origin), stride_(arranger_type::get_stride(range)), data_container_(make_container(data.begin(), data.end())) {
                 assert(range.size() == data.size());
                 assert(range.contains(origin));
             };
             
             Tensor(const index_type& range, const pointer& data) 
-            : range_(range_), origin_(0), data_container_(RepType_(data, data + range.size())){
+            : range_(range), origin_(0), stride_(arranger_type::get_stride(range)), data_container_(make_container(data, data + range.size())){
             }
             
-            Tensor(const Tensor& other) {
+            /**
+             * Creates a tensor on the memory owned by another object (e.g. a
+             * MappedFile), which is kept alive with the aliasing shared
+             * pointer as long as the tensor uses it.
+             * @param range
+             * @param memory: at least range.size() values
+             * @param is_writable: if false the values are copied to the
+             *        memory of the tensor on the first write access
+             */
+            Tensor(const index_type& range, const std::shared_ptr<DataType_>& memory, bool is_writable)
+            : range_(range), origin_(0), stride_(arranger_type::get_stride(range)), data_container_(), 
+              external_memory_(memory), is_external_writable_(is_writable) {
+                assert(memory || range.size() == 0);
+            }
+            
+            /**
+             * Creates a tensor holding a copy of the elements referred by the view
+             */
+            template<typename ViewDataType_,
+                     typename = typename std::enable_if<std::is_same<typename std::remove_const<ViewDataType_>::type, DataType_>::value>::type>
+            Tensor(const TensorView<ViewDataType_, rank_, order_>& view)
+            : range_(view.range()), origin_(view.origin()), stride_(arranger_type::get_stride(view.range())), data_container_(make_container(view.size())) {
+                RepType_& values = *data_container_;
+                if (view.is_contiguous()) std::copy(view.data(), view.data() + view.size(), values.begin());
+                else for (size_type id = 0; id < view.size(); ++id) values[id] = view[id];
+            }
+            
+            /**
+             * Creates a tensor evaluating the expression
+             */
+            template<typename Expression_>
+            Tensor(const TensorExpression<Expression_>& expr)
+            : range_(expr.self().range()), origin_(expr.self().origin()), stride_(arranger_type::get_stride(range_)), data_container_(make_container(range_.size())) {
+                evaluate(expr, expression::Assign());
+            }
+            
+            /**
+             * Creates a deep copy of the other tensor
+             */
+            Tensor(const Tensor& other)
+            : Tensor() {
                 reset(other);
             };
 
-            Tensor(Tensor&& other) {
-                reset(other);
+            /**
+             * Takes over the memory of the other tensor, which is left empty
+             */
+            Tensor(Tensor&& other) noexcept
+            : Tensor() {
+                reset(std::move(other));
             };
             
             Tensor& operator=(const Tensor& right) {
@@ -108,8 +224,63 @@ namespace em {
                 return *this;
             }
  
-            Tensor& operator=(Tensor&& right) {
-                if (this != &right) reset(right);
+            Tensor& operator=(Tensor&& right) noexcept {
+                if (this != &right) reset(std::move(right));
+                return *this;
+            }
+            
+            /**
+             * Creates a tensor sharing the memory with this tensor. No data
+             * is copied until one of the tensors is written, e.g. for
+             * read-only copies.
+             * 
+             * The copy on write is only triggered by the accesses made 
+             * after sharing: pointers, references, iterators and views 
+             * obtained from either tensor before share() still point to
+             * the shared memory, a write through them changes both 
+             * tensors. They must not be used for writes once the tensor is
+             * shared, take them again from the tensor instead.
+             */
+            Tensor share() const {
+                Tensor shared;
+                shared.range_ = range_;
+                shared.origin_ = origin_;
+                shared.stride_ = stride_;
+                shared.data_container_ = data_container_;
+                shared.external_memory_ = external_memory_;
+                shared.is_external_writable_ = is_external_writable_;
+                return shared;
+            }
+            
+            /**
+             * Checks if the memory is shared with another tensor
+             */
+            bool is_shared() const {
+                if (external_memory_) return external_memory_.use_count() > 1;
+                return data_container_ && data_container_.use_count() > 1;
+            }
+            
+            /**
+             * Checks if the memory is owned by the tensor, i.e. it is not
+             * the memory of another object (e.g. a mapped file)
+             */
+            bool owns_memory() const {
+                return !external_memory_;
+            }
+            
+            /**
+             * Evaluates the expression into this tensor. The expression can
+             * refer to this tensor itself, e.g. a = a*w + b.
+             */
+            template<typename Expression_>
+            Tensor& operator=(const TensorExpression<Expression_>& expr) {
+                if (range_ != expr.self().range()) {
+                    //Evaluate in new memory as the expression can not refer to this tensor
+                    reset(Tensor(expr));
+                } else {
+                    origin_ = expr.self().origin();
+                    evaluate(expr, expression::Assign());
+                }
                 return *this;
             }
             
@@ -119,74 +290,102 @@ namespace em {
              */
             
             virtual const_reference operator[](const index_type& idx) const {
-                size_type memory_id = arranger_type::map(idx, range_, origin_);
-                return data_container_[memory_id];
+                size_type memory_id = arranger_type::map(idx, range_, origin_, stride_);
+                return data()[memory_id];
             }
 
             virtual reference operator[](const index_type& idx) {
-                return const_cast<reference> (static_cast<const Tensor<data_type, rank_, order_> &> (*this).operator[](idx));
+                size_type memory_id = arranger_type::map(idx, range_, origin_, stride_);
+                return data()[memory_id];
             }
 
             virtual const_reference at(const index_type& idx) const {
-                size_type memory_id = arranger_type::map(idx, range_, origin_);
-                return data_container_.at(memory_id);
+                size_type memory_id = arranger_type::map(idx, range_, origin_, stride_);
+                return data()[checked_id(memory_id)];
             }
             
             virtual reference at(const index_type& idx) {
-                size_type memory_id = arranger_type::map(idx, range_, origin_);
-                return data_container_.at(memory_id);
+                size_type memory_id = arranger_type::map(idx, range_, origin_, stride_);
+                return data()[checked_id(memory_id)];
             }
             
             const_reference operator[](const size_type& idx) const {
                 assert(range_.size() > idx);
-                return data_container_[idx];
+                return data()[idx];
             }
 
             reference operator[](const size_type& idx) {
                 assert(range_.size() > idx);
-                return data_container_[idx];
+                return data()[idx];
             }
 
             const_reference at(const size_type& idx) const {
                 assert(range_.size() > idx);
-                return data_container_.at(idx);
+                return data()[checked_id(idx)];
             }
             
             reference at(const size_type& idx) {
                 assert(range_.size() > idx);
-                return data_container_.at(idx);
+                return data()[checked_id(idx)];
             }
 
-            const pointer data() const {
-                return data_container_.data();
+            const_pointer data() const {
+                if (external_memory_) return external_memory_.get();
+                return data_container_ ? data_container_->data() : nullptr;
             }
 
+            /**
+             * Copies the memory first if it is shared. The pointer is only
+             * private to this tensor until the next share() (see share()).
+             */
             pointer data() {
-                return data_container_.data();
+                detach();
+                if (external_memory_) return external_memory_.get();
+                return data_container_->data();
+            }
+
+            /**
+             * Returns a view referring to all the elements of the tensor
+             */
+            view_type view() {
+                return view_type(data(), range_, stride(), origin_);
+            }
+            
+            const_view_type view() const {
+                return const_view_type(data(), range_, stride(), origin_);
             }
 
+            /**
+             * The vector holding the values. The values in the memory of
+             * another object are first copied to the memory of the tensor.
+             */
             RepType_& vectorize() {
-                return data_container_;
+                return container();
             }
 
+            /**
+             * The vector holding the values, only for tensors owning their
+             * memory (see owns_memory()).
+             */
             const RepType_& vectorize() const {
-                return data_container_;
+                assert(owns_memory());
+                return container();
             }
             
-            const reference front() const {
-                return data_container_.front();
+            const_reference front() const {
+                return data()[checked_id(0)];
             }
             
             reference front() {
-                return data_container_.front();
+                return data()[checked_id(0)];
             }
             
-            const reference back() const {
-                return data_container_.back();
+            const_reference back() const {
+                return data()[checked_id(memory_size() - 1)];
             }
             
             reference back() {
-                return data_container_.back();
+                return data()[checked_id(memory_size() - 1)];
             }
 
             
@@ -252,59 +451,80 @@ namespace em {
             }
 
             index_type stride() const {
-                return arranger_type::get_stride(range_);
+                return stride_;
             }
 
             bool empty() const {
-                return data_container_.empty();
+                return memory_size() == 0;
             }
             
             /*
              * Modifiers
              */
             
+            /**
+             * Changes the origin keeping the values at their logical indices.
+             * The memory is circularly shifted in place by the difference
+             * of the origins (see circular_shift).
+             */
             void transform_origin(const index_type& new_origin) {
-       
-                //TODO: Program this efficiently with memory copy
-                
-                Tensor<data_type, rank_, order_> temp(range(), new_origin, data_type());
-                for (const auto& itr : *this) {
-                    temp.at(itr.index()) = itr.value();
-                }
-                this->reset(temp);
+                assert(range_.contains(new_origin));
+                if (new_origin == origin_) return;
+                circular_shift<order_>(data(), range_, new_origin - origin_);
+                origin_ = new_origin;
             }
             
             void reshape(const index_type& new_range) {
                 assert(new_range.size() ==  range_.size());
                 range_ = new_range;
+                stride_ = arranger_type::get_stride(range_);
             }
             
             void resize(const index_type& range) {
                 assert(range.contains(origin()));
+                //The values are copied out of shared or external memory 
+                //with the current range, before it changes
+                own_memory();
                 range_ = range;
-                data_container_.resize(range.size());
+                stride_ = arranger_type::get_stride(range_);
+                container().resize(range.size());
             }
             
-            template<StorageOrder order>
-            void reset(const Tensor<data_type, rank_, order>& other) {
+            /**
+             * Copies the other tensor. The memory of this tensor is reused
+             * if it is not shared.
+             */
+            template<StorageOrder order, typename OtherAllocator_>
+            void reset(const Tensor<data_type, rank_, order, OtherAllocator_>& other) {
                 range_ = other.range_;
                 origin_ = other.origin_;
-                if(order == order_) data_container_ = other.data_container_;
+                stride_ = arranger_type::get_stride(range_);
+                own_memory(false);
+                if(order == order_) data_container_->assign(other.data(), other.data() + other.memory_size());
                 else {
-                    for(const auto& data : other) {
-                        at(data.index()) = data.value();
-                    }
+                    data_container_->resize(range_.size());
+                    change_storage_order<order, order_>(other.data(), range_, data_container_->data());
                 }
             }
             
-            void reset(Tensor&& other) {
-                range_ = std::move(other.range_);
-                origin_ = std::move(other.origin_);
+            /**
+             * Takes over the memory of the other tensor, which is left empty
+             */
+            void reset(Tensor&& other) noexcept {
+                range_ = other.range_;
+                origin_ = other.origin_;
+                stride_ = other.stride_;
                 data_container_ = std::move(other.data_container_);
+                external_memory_ = std::move(other.external_memory_);
+                is_external_writable_ = other.is_external_writable_;
+                other.range_ = index_type(0);
+                other.origin_ = index_type(0);
+                other.stride_ = arranger_type::get_stride(other.range_);
             }
             
             void clear() {
-                data_container_.clear();
+                data_container_.reset();
+                external_memory_.reset();
             }
             
             void insert(const index_type& idx, const data_type& value) {
@@ -328,149 +548,242 @@ namespace em {
             }
             
             /**
-             * Arithmetic operations
+             * Compound arithmetic operations
+             * Update the elements in place with an expression (or a tensor)
+             * of the same range and origin, or with a scalar.
              */
-            SelfType_ operator+(const SelfType_& right) const {
-                assert(range() == right.range());
-                static_assert(std::is_arithmetic<data_type>::value, "The value_type in the tensor class should be arithmetic");
-                SelfType_ result(range());
-                std::transform(data_container_.begin(), data_container_.end(), right.data_container_.begin(),
-                        std::back_inserter(result.data_container_), std::plus<data_type>());
-                return result;
+            template<typename Expression_>
+            SelfType_& operator+=(const TensorExpression<Expression_>& right) {
+                evaluate(right, expression::PlusAssign());
+                return *this;
             }
 
-            SelfType_& operator+=(const SelfType_& right) {
-                return *this +right;
+            template<typename Expression_>
+            SelfType_& operator-=(const TensorExpression<Expression_>& right) {
+                evaluate(right, expression::MinusAssign());
+                return *this;
             }
 
-            SelfType_ operator-(const SelfType_& right) const {
-                assert(range() == right.range());
-                static_assert(std::is_arithmetic<data_type>::value, "The value_type in the tensor class should be arithmetic");
-                SelfType_ result(range());
-                std::transform(data_container_.begin(), data_container_.end(), right.data_container_.begin(),
-                        std::back_inserter(result.data_container_), std::minus<data_type>());
-                return result;
+            template<typename Expression_>
+            SelfType_& operator*=(const TensorExpression<Expression_>& right) {
+                evaluate(right, expression::MultipliesAssign());
+                return *this;
             }
 
-            SelfType_& operator-=(const SelfType_& right) {
-                return *this-right;
+            template<typename Expression_>
+            SelfType_& operator/=(const TensorExpression<Expression_>& right) {
+                evaluate(right, expression::DividesAssign());
+                return *this;
             }
 
-            template<typename ArithmaticType_>
-            SelfType_ operator+(const ArithmaticType_& right) {
-                static_assert(std::is_arithmetic<data_type>::value, "The value_type in the tensor class should be arithmetic");
-                static_assert(std::is_arithmetic<ArithmaticType_>::value, "The value_type should be arithmetic");
-                std::for_each(data_container_.begin(), data_container_.end(), [&](data_type val) {
-                    return val + right;
-                });
+            template<typename Scalar_>
+            typename std::enable_if<!is_tensor_expression<Scalar_>::value, SelfType_&>::type
+            operator+=(const Scalar_& right) {
+                apply(right, expression::PlusAssign());
+                return *this;
             }
 
-            template<typename ArithmaticType_>
-            SelfType_ operator-(const ArithmaticType_& right) {
-                static_assert(std::is_arithmetic<data_type>::value, "The value_type in the tensor class should be arithmetic");
-                static_assert(std::is_arithmetic<ArithmaticType_>::value, "The value_type should be arithmetic");
-                std::for_each(data_container_.begin(), data_container_.end(), [&](data_type val) {
-                    return val - right;
-                });
+            template<typename Scalar_>
+            typename std::enable_if<!is_tensor_expression<Scalar_>::value, SelfType_&>::type
+            operator-=(const Scalar_& right) {
+                apply(right, expression::MinusAssign());
+                return *this;
             }
 
-            template<typename ArithmaticType_>
-            SelfType_ operator*(const ArithmaticType_& right) {
-                static_assert(std::is_arithmetic<data_type>::value, "The value_type in the tensor class should be arithmetic");
-                static_assert(std::is_arithmetic<ArithmaticType_>::value, "The value_type should be arithmetic");
-                std::for_each(data_container_.begin(), data_container_.end(), [&](data_type val) {
-                    return val*right;
-                });
+            template<typename Scalar_>
+            typename std::enable_if<!is_tensor_expression<Scalar_>::value, SelfType_&>::type
+            operator*=(const Scalar_& right) {
+                apply(right, expression::MultipliesAssign());
+                return *this;
+            }
+
+            template<typename Scalar_>
+            typename std::enable_if<!is_tensor_expression<Scalar_>::value, SelfType_&>::type
+            operator/=(const Scalar_& right) {
+                apply(right, expression::DividesAssign());
+                return *this;
             }
 
             /**
              * Slicing
+             * The slices are views on the memory of this tensor with the
+             * last index fixed to slice_number.
              */
 
-            Tensor<data_type, rank_ - 1, order_> slice(typename index_type::value_type slice_number) const {
-                static_assert(rank_ > 1, "The rank should be more than 1 for slicing");
-                assert(slice_number < range_[rank_ - 1]);
-                Index < rank_ - 1 > slice_range;
-                for (int i = 0; i < rank_ - 1; ++i) slice_range[i] = range_[i];
-                size_t start = slice_number * slice_range.size();
-                size_t extent = (slice_number+1) * slice_range.size();
-                RepType_ slice_vector = RepType_(data_container_.data() + start, data_container_.data() + extent);
-                Tensor<data_type, rank_ - 1, order_> sliced(slice_range, slice_vector); 
-                return sliced;
+            TensorView<data_type, rank_ - 1, order_> slice(typename index_type::value_type slice_number) {
+                return view().slice(slice_number);
+            }
+            
+            TensorView<const data_type, rank_ - 1, order_> slice(typename index_type::value_type slice_number) const {
+                return view().slice(slice_number);
             }
             
-            void set_slice(typename index_type::value_type slice_number, Tensor<data_type, rank_ - 1, order_> slice) {
+            template<typename SliceType_>
+            void set_slice(typename index_type::value_type slice_number, const SliceType_& slice) {
                 static_assert(rank_ > 1, "The rank should be more than 1 for setting slices");
                 assert(slice_number < range_[rank_ - 1]);
-                
-                Index < rank_ - 1 > slice_range;
-                for (int i = 0; i < rank_ - 1; ++i) slice_range[i] = range_[i];
-                assert(slice_range.size() == slice.range().size());
-                
-                RepType_ slice_vector = slice.vectorize();
-                for(int i=0; i<slice_range.size(); ++i) {
-                    data_container_[i + slice_number * slice_range.size()] = slice_vector[i];
-                }
+                view().slice(slice_number).assign(slice);
             }
 
 
             /**
              * Sectioning
+             * The section is a view on the sub-box of this tensor starting
+             * at begin_index and with the range section_range, which must 
+             * not wrap around the memory (see TensorView::section).
              */
 
-            SelfType_ section(const index_type& begin_index, const index_type& section_range) const {
-                assert(range_.contains(section_range + begin_index - index_type(1)));
-                SelfType_ cut(section_range, data_type());
-                for(auto& val : cut) {
-                    val.value() = at(val.index()+begin_index);
-                }
-                return cut;
+            view_type section(const index_type& begin_index, const index_type& section_range) {
+                return view().section(begin_index, section_range);
+            }
+            
+            const_view_type section(const index_type& begin_index, const index_type& section_range) const {
+                return view().section(begin_index, section_range);
             }
 
 
         private:
+            
+            /**
+             * Evaluates the expression element by element in the memory order
+             * and combines it with the current values using the assignment.
+             * The blocks of the memory are evaluated in parallel.
+             * The expression can refer to the memory this tensor releases
+             * when detaching (e.g. t = t * 2 on a mapped file), which is 
+             * kept alive until the evaluation is done.
+             */
+            template<typename Expression_, typename Assignment_>
+            void evaluate(const TensorExpression<Expression_>& expr, Assignment_ assignment) {
+                assert(range_ == expr.self().range());
+                assert(origin_ == expr.self().origin());
+                const std::shared_ptr<DataType_> released = detach();
+                const auto node = expression::make_node(expr);
+                pointer values = data();
+                parallel::parallel_for(size(), parallel::block_size<data_type>(), [&](size_type begin, size_type end) {
+                    for (size_type id = begin; id < end; ++id) assignment(values[id], node[id]);
+                });
+            }
+            
+            template<typename Scalar_, typename Assignment_>
+            void apply(const Scalar_& scalar, Assignment_ assignment) {
+                pointer values = data();
+                parallel::parallel_for(size(), parallel::block_size<data_type>(), [&](size_type begin, size_type end) {
+                    for (size_type id = begin; id < end; ++id) assignment(values[id], scalar);
+                });
+            }
+
+            /**
+             * Creates a vector for the memory. The vector and its shared
+             * pointer are both allocated with the allocator policy.
+             */
+            template<typename... Args_>
+            static std::shared_ptr<RepType_> make_container(Args_&&... args) {
+                return std::allocate_shared<RepType_>(Allocator_(), std::forward<Args_>(args)...);
+            }
+            
+            /**
+             * The vector owned by the tensor (empty if there is none)
+             */
+            const RepType_& container() const {
+                static const RepType_ empty_container;
+                return data_container_ ? *data_container_ : empty_container;
+            }
+            
+            /**
+             * The vector owned by the tensor for writing, which is not shared
+             */
+            RepType_& container() {
+                own_memory();
+                return *data_container_;
+            }
+            
+            /**
+             * Number of values in the memory
+             */
+            size_type memory_size() const {
+                if (external_memory_) return range_.size();
+                return data_container_ ? data_container_->size() : 0;
+            }
+            
+            size_type checked_id(size_type memory_id) const {
+                if (memory_id >= memory_size()) throw std::out_of_range("Tensor: memory id out of range");
+                return memory_id;
+            }
+            
+            /**
+             * Makes sure that the memory can be written and is not shared 
+             * with other tensors. The writable external memory is used 
+             * as long as it is not shared.
+             * @return the external memory released, if any
+             */
+            std::shared_ptr<DataType_> detach(bool keep_values = true) {
+                if (external_memory_ && is_external_writable_ && external_memory_.use_count() == 1) return nullptr;
+                return own_memory(keep_values);
+            }
+            
+            /**
+             * Makes sure that the values are in a vector owned by the tensor
+             * and not shared with other tensors by copying the memory (or
+             * not if the values are to be overwritten).
+             * @return the external memory released, if any
+             */
+            std::shared_ptr<DataType_> own_memory(bool keep_values = true) {
+                std::shared_ptr<DataType_> released;
+                if (external_memory_) {
+                    const_pointer values = external_memory_.get();
+                    data_container_ = keep_values ? make_container(values, values + range_.size()) : make_container();
+                    released.swap(external_memory_);
+                } else if (!data_container_) data_container_ = make_container();
+                else if (data_container_.use_count() > 1) {
+                    data_container_ = keep_values ? make_container(*data_container_) : make_container();
+                }
+                return released;
+            }
 
             index_type range_;
             index_type origin_;
-            RepType_ data_container_;
+            index_type stride_;
+            std::shared_ptr<RepType_> data_container_;
+            std::shared_ptr<DataType_> external_memory_;
+            bool is_external_writable_ = false;
 
         };
         
         
-        template<typename DataType_, size_t rank_, StorageOrder order_>
-        bool operator==(const Tensor<DataType_, rank_, order_>& lhs,
-                const Tensor<DataType_, rank_, order_>& rhs) {
-            return(lhs.range() == rhs.range() && lhs.vectorize() == rhs.vectorize());
+        template<typename DataType_, size_t rank_, StorageOrder order_, typename Allocator_>
+        bool operator==(const Tensor<DataType_, rank_, order_, Allocator_>& lhs,
+                const Tensor<DataType_, rank_, order_, Allocator_>& rhs) {
+            return(lhs.range() == rhs.range() && std::equal(lhs.data(), lhs.data() + lhs.size(), rhs.data()));
         };
         
-        template<typename DataType_, size_t rank_, StorageOrder order_>
-        bool operator!=(const Tensor<DataType_, rank_, order_>& lhs,
-                const Tensor<DataType_, rank_, order_>& rhs) {
-            return(lhs.range() != rhs.range() || lhs.vectorize() != rhs.vectorize());
+        template<typename DataType_, size_t rank_, StorageOrder order_, typename Allocator_>
+        bool operator!=(const Tensor<DataType_, rank_, order_, Allocator_>& lhs,
+                const Tensor<DataType_, rank_, order_, Allocator_>& rhs) {
+            return !(lhs == rhs);
         };
         
-        template<typename DataType_, size_t rank_, StorageOrder order_>
-        bool operator<(const Tensor<DataType_, rank_, order_>& lhs,
-                const Tensor<DataType_, rank_, order_>& rhs) {
-            return(lhs.vectorize() < rhs.vectorize());
+        template<typename DataType_, size_t rank_, StorageOrder order_, typename Allocator_>
+        bool operator<(const Tensor<DataType_, rank_, order_, Allocator_>& lhs,
+                const Tensor<DataType_, rank_, order_, Allocator_>& rhs) {
+            return std::lexicographical_compare(lhs.data(), lhs.data() + lhs.size(), rhs.data(), rhs.data() + rhs.size());
         };
         
-        template<typename DataType_, size_t rank_, StorageOrder order_>
-        bool operator<=(const Tensor<DataType_, rank_, order_>& lhs,
-                const Tensor<DataType_, rank_, order_>& rhs) {
-            return(lhs.vectorize() <= rhs.vectorize());
+        template<typename DataType_, size_t rank_, StorageOrder order_, typename Allocator_>
+        bool operator<=(const Tensor<DataType_, rank_, order_, Allocator_>& lhs,
+                const Tensor<DataType_, rank_, order_, Allocator_>& rhs) {
+            return !(rhs < lhs);
         };
         
-        template<typename DataType_, size_t rank_, StorageOrder order_>
-        bool operator>(const Tensor<DataType_, rank_, order_>& lhs,
-                const Tensor<DataType_, rank_, order_>& rhs) {
-            return(lhs.vectorize() > rhs.vectorize());
+        template<typename DataType_, size_t rank_, StorageOrder order_, typename Allocator_>
+        bool operator>(const Tensor<DataType_, rank_, order_, Allocator_>& lhs,
+                const Tensor<DataType_, rank_, order_, Allocator_>& rhs) {
+            return rhs < lhs;
         };
         
-        template<typename DataType_, size_t rank_, StorageOrder order_>
-        bool operator>=(const Tensor<DataType_, rank_, order_>& lhs,
-                const Tensor<DataType_, rank_, order_>& rhs) {
-            return(lhs.vectorize() >= rhs.vectorize());
+        template<typename DataType_, size_t rank_, StorageOrder order_, typename Allocator_>
+        bool operator>=(const Tensor<DataType_, rank_, order_, Allocator_>& lhs,
+                const Tensor<DataType_, rank_, order_, Allocator_>& rhs) {
+            return !(lhs < rhs);
         };
     }
 }
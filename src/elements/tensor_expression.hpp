@@ -0,0 +1,504 @@
+/* 
+ * This file is a part of emkit.
+ * 
+ * emkit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * emkit is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>
+ * 
+ * Author:
+ * Nikhil Biyani: nikhil(dot)biyani(at)gmail(dot)com
+ * 
+ */
+
+#ifndef EM_MULTIDIM_TENSOR_EXPRESSION_HPP
+#define EM_MULTIDIM_TENSOR_EXPRESSION_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "tensor_storage_order.hpp"
+#include "aligned_allocator.hpp"
+
+namespace em {
+    namespace element {
+
+        template<typename DataType_, size_t rank_, StorageOrder order_, typename Allocator_>
+        class Tensor;
+
+        /**
+         * @brief       Base of all the element-wise tensor expressions
+         * @description Arithmetic on tensors does not compute anything, it
+         *              builds a light weight expression tree which is
+         *              evaluated only when assigned to a tensor. The
+         *              complete expression (e.g. a*w1 + b*w2 - c) is then
+         *              evaluated in a single loop over the memory without
+         *              any temporary tensors.
+         *
+         *              All the operands of an expression should have the
+         *              same range, origin and storage order, the elements
+         *              are combined position by position in the memory.
+         *              The expressions refer to the data of the tensors,
+         *              they should not outlive the tensors they are built
+         *              from. The terminals of a tree can be inspected with
+         *              visit_terminals(visitor), which calls visitor(terminal)
+         *              for every terminal from left to right.
+         */
+        template<typename Expression_>
+        class TensorExpression {
+        public:
+
+            const Expression_& self() const {
+                return static_cast<const Expression_&> (*this);
+            }
+
+        };
+
+        /**
+         * Checks if the type is a tensor or an expression of tensors
+         */
+        template<typename Type_>
+        struct is_tensor_expression {
+        private:
+            template<typename Expression_>
+            static std::true_type test(const TensorExpression<Expression_>*);
+            static std::false_type test(...);
+
+        public:
+            static const bool value = decltype(test(std::declval<typename std::decay<Type_>::type*>()))::value;
+        };
+
+        /**
+         * Value type resulting from an element-wise operation
+         */
+        template<typename Operation_, typename Lhs_, typename Rhs_>
+        struct expression_result {
+            using type = typename std::decay<decltype(Operation_()(std::declval<Lhs_>(), std::declval<Rhs_>()))>::type;
+        };
+
+        /**
+         * Leaf of an expression tree, refers to the contiguous memory of a
+         * tensor
+         */
+        template<typename DataType_, size_t rank_, StorageOrder order_>
+        class TensorTerminal : public TensorExpression<TensorTerminal<DataType_, rank_, order_>> {
+        public:
+            static const int rank = rank_;
+            static const StorageOrder storage_order = order_;
+            using index_type = Index<rank_>;
+            using data_type = DataType_;
+            using size_type = typename index_type::size_type;
+
+            /**
+             * @param source: tensor the memory belongs to, if it uses the
+             *        default allocator (see source())
+             */
+            TensorTerminal(const DataType_* data, const index_type& range, const index_type& origin,
+                    const Tensor<DataType_, rank_, order_, AlignedAllocator<DataType_>>* source = nullptr)
+            : data_(data), range_(range), origin_(origin), source_(source) {
+            }
+
+            /**
+             * The tensor the terminal refers to, e.g. to check properties
+             * of derived objects. Null for the tensors with other 
+             * allocators.
+             */
+            const Tensor<DataType_, rank_, order_, AlignedAllocator<DataType_>>* source() const {
+                return source_;
+            }
+
+            template<typename Visitor_>
+            void visit_terminals(Visitor_& visitor) const {
+                visitor(*this);
+            }
+
+            const data_type& operator[](size_type id) const {
+                return data_[id];
+            }
+
+            index_type range() const {
+                return range_;
+            }
+
+            index_type origin() const {
+                return origin_;
+            }
+
+            size_type size() const {
+                return range_.size();
+            }
+
+        private:
+            const DataType_* data_;
+            index_type range_;
+            index_type origin_;
+            const Tensor<DataType_, rank_, order_, AlignedAllocator<DataType_>>* source_;
+        };
+
+        /**
+         * Element-wise operation on two expressions
+         */
+        template<typename Operation_, typename Lhs_, typename Rhs_>
+        class TensorBinaryExpression : public TensorExpression<TensorBinaryExpression<Operation_, Lhs_, Rhs_>> {
+        public:
+            static_assert(Lhs_::rank == Rhs_::rank, "The operands should be of the same rank");
+            static_assert(Lhs_::storage_order == Rhs_::storage_order, "The operands should be of the same storage order");
+
+            static const int rank = Lhs_::rank;
+            static const StorageOrder storage_order = Lhs_::storage_order;
+            using index_type = typename Lhs_::index_type;
+            using data_type = typename expression_result<Operation_, typename Lhs_::data_type, typename Rhs_::data_type>::type;
+            using size_type = typename index_type::size_type;
+
+            TensorBinaryExpression(const Lhs_& lhs, const Rhs_& rhs)
+            : lhs_(lhs), rhs_(rhs) {
+                assert(lhs.range() == rhs.range());
+                assert(lhs.origin() == rhs.origin());
+            }
+
+            data_type operator[](size_type id) const {
+                return Operation_()(lhs_[id], rhs_[id]);
+            }
+
+            template<typename Visitor_>
+            void visit_terminals(Visitor_& visitor) const {
+                lhs_.visit_terminals(visitor);
+                rhs_.visit_terminals(visitor);
+            }
+
+            index_type range() const {
+                return lhs_.range();
+            }
+
+            index_type origin() const {
+                return lhs_.origin();
+            }
+
+            size_type size() const {
+                return lhs_.size();
+            }
+
+        private:
+            Lhs_ lhs_;
+            Rhs_ rhs_;
+        };
+
+        /**
+         * Element-wise operation of an expression with a scalar. The scalar
+         * is the left operand if scalar_first_ is set.
+         */
+        template<typename Operation_, typename Expression_, typename Scalar_, bool scalar_first_>
+        class TensorScalarExpression : public TensorExpression<TensorScalarExpression<Operation_, Expression_, Scalar_, scalar_first_>> {
+        public:
+            static const int rank = Expression_::rank;
+            static const StorageOrder storage_order = Expression_::storage_order;
+            using index_type = typename Expression_::index_type;
+            using data_type = typename std::conditional<scalar_first_,
+                    expression_result<Operation_, Scalar_, typename Expression_::data_type>,
+                    expression_result<Operation_, typename Expression_::data_type, Scalar_>>::type::type;
+            using size_type = typename index_type::size_type;
+
+            TensorScalarExpression(const Expression_& expression, const Scalar_& scalar)
+            : expression_(expression), scalar_(scalar) {
+            }
+
+            data_type operator[](size_type id) const {
+                return evaluate(id, std::integral_constant<bool, scalar_first_>());
+            }
+
+            template<typename Visitor_>
+            void visit_terminals(Visitor_& visitor) const {
+                expression_.visit_terminals(visitor);
+            }
+
+            index_type range() const {
+                return expression_.range();
+            }
+
+            index_type origin() const {
+                return expression_.origin();
+            }
+
+            size_type size() const {
+                return expression_.size();
+            }
+
+        private:
+
+            data_type evaluate(size_type id, std::true_type) const {
+                return Operation_()(scalar_, expression_[id]);
+            }
+
+            data_type evaluate(size_type id, std::false_type) const {
+                return Operation_()(expression_[id], scalar_);
+            }
+
+            Expression_ expression_;
+            Scalar_ scalar_;
+        };
+
+        /**
+         * Element-wise operation on a single expression
+         */
+        template<typename Operation_, typename Expression_>
+        class TensorUnaryExpression : public TensorExpression<TensorUnaryExpression<Operation_, Expression_>> {
+        public:
+            static const int rank = Expression_::rank;
+            static const StorageOrder storage_order = Expression_::storage_order;
+            using index_type = typename Expression_::index_type;
+            using data_type = typename std::decay<decltype(Operation_()(std::declval<typename Expression_::data_type>()))>::type;
+            using size_type = typename index_type::size_type;
+
+            TensorUnaryExpression(const Expression_& expression)
+            : expression_(expression) {
+            }
+
+            data_type operator[](size_type id) const {
+                return Operation_()(expression_[id]);
+            }
+
+            template<typename Visitor_>
+            void visit_terminals(Visitor_& visitor) const {
+                expression_.visit_terminals(visitor);
+            }
+
+            index_type range() const {
+                return expression_.range();
+            }
+
+            index_type origin() const {
+                return expression_.origin();
+            }
+
+            size_type size() const {
+                return expression_.size();
+            }
+
+        private:
+            Expression_ expression_;
+        };
+
+        namespace expression {
+
+            /**
+             * Element-wise operations used in the expressions
+             */
+
+            struct Plus {
+
+                template<typename Lhs_, typename Rhs_>
+                auto operator()(const Lhs_& lhs, const Rhs_& rhs) const -> decltype(lhs + rhs) {
+                    return lhs + rhs;
+                }
+            };
+
+            struct Minus {
+
+                template<typename Lhs_, typename Rhs_>
+                auto operator()(const Lhs_& lhs, const Rhs_& rhs) const -> decltype(lhs - rhs) {
+                    return lhs - rhs;
+                }
+            };
+
+            struct Multiplies {
+
+                template<typename Lhs_, typename Rhs_>
+                auto operator()(const Lhs_& lhs, const Rhs_& rhs) const -> decltype(lhs * rhs) {
+                    return lhs * rhs;
+                }
+            };
+
+            struct Divides {
+
+                template<typename Lhs_, typename Rhs_>
+                auto operator()(const Lhs_& lhs, const Rhs_& rhs) const -> decltype(lhs / rhs) {
+                    return lhs / rhs;
+                }
+            };
+
+            struct Negate {
+
+                template<typename Type_>
+                auto operator()(const Type_& value) const -> decltype(-value) {
+                    return -value;
+                }
+            };
+
+            /**
+             * Assignments used to store the evaluated expressions
+             */
+
+            struct Assign {
+
+                template<typename Lhs_, typename Rhs_>
+                void operator()(Lhs_& lhs, const Rhs_& rhs) const {
+                    lhs = rhs;
+                }
+            };
+
+            struct PlusAssign {
+
+                template<typename Lhs_, typename Rhs_>
+                void operator()(Lhs_& lhs, const Rhs_& rhs) const {
+                    lhs = lhs + rhs;
+                }
+            };
+
+            struct MinusAssign {
+
+                template<typename Lhs_, typename Rhs_>
+                void operator()(Lhs_& lhs, const Rhs_& rhs) const {
+                    lhs = lhs - rhs;
+                }
+            };
+
+            struct MultipliesAssign {
+
+                template<typename Lhs_, typename Rhs_>
+                void operator()(Lhs_& lhs, const Rhs_& rhs) const {
+                    lhs = lhs * rhs;
+                }
+            };
+
+            struct DividesAssign {
+
+                template<typename Lhs_, typename Rhs_>
+                void operator()(Lhs_& lhs, const Rhs_& rhs) const {
+                    lhs = lhs / rhs;
+                }
+            };
+
+            /**
+             * Converts an operand to the node stored in the expression tree.
+             * Tensors are stored as terminals referring to their memory,
+             * other expressions are stored by value.
+             */
+            template<typename Expression_>
+            struct node {
+                using type = Expression_;
+
+                static const type& make(const Expression_& expression) {
+                    return expression;
+                }
+            };
+
+            template<typename DataType_, size_t rank_, StorageOrder order_, typename Allocator_>
+            struct node<Tensor<DataType_, rank_, order_, Allocator_>> {
+                using type = TensorTerminal<DataType_, rank_, order_>;
+
+                static type make(const Tensor<DataType_, rank_, order_, Allocator_>& tensor) {
+                    return type(tensor.data(), tensor.range(), tensor.origin(), nullptr);
+                }
+            };
+
+            template<typename DataType_, size_t rank_, StorageOrder order_>
+            struct node<Tensor<DataType_, rank_, order_, AlignedAllocator<DataType_>>> {
+                using type = TensorTerminal<DataType_, rank_, order_>;
+
+                static type make(const Tensor<DataType_, rank_, order_, AlignedAllocator<DataType_>>& tensor) {
+                    return type(tensor.data(), tensor.range(), tensor.origin(), &tensor);
+                }
+            };
+
+            template<typename Expression_>
+            typename node<Expression_>::type make_node(const TensorExpression<Expression_>& expression) {
+                return node<Expression_>::make(expression.self());
+            }
+
+            template<typename Operation_, typename Lhs_, typename Rhs_>
+            using binary_type = TensorBinaryExpression<Operation_, typename node<Lhs_>::type, typename node<Rhs_>::type>;
+
+            template<typename Operation_, typename Expression_, typename Scalar_, bool scalar_first_>
+            using scalar_type = typename std::enable_if<!is_tensor_expression<Scalar_>::value,
+                    TensorScalarExpression<Operation_, typename node<Expression_>::type, Scalar_, scalar_first_>>::type;
+
+        }
+
+        /**
+         * Arithmetic operators building the expressions
+         */
+
+        template<typename Lhs_, typename Rhs_>
+        expression::binary_type<expression::Plus, Lhs_, Rhs_>
+        operator+(const TensorExpression<Lhs_>& lhs, const TensorExpression<Rhs_>& rhs) {
+            return expression::binary_type<expression::Plus, Lhs_, Rhs_>(expression::make_node(lhs), expression::make_node(rhs));
+        }
+
+        template<typename Lhs_, typename Rhs_>
+        expression::binary_type<expression::Minus, Lhs_, Rhs_>
+        operator-(const TensorExpression<Lhs_>& lhs, const TensorExpression<Rhs_>& rhs) {
+            return expression::binary_type<expression::Minus, Lhs_, Rhs_>(expression::make_node(lhs), expression::make_node(rhs));
+        }
+
+        template<typename Lhs_, typename Rhs_>
+        expression::binary_type<expression::Multiplies, Lhs_, Rhs_>
+        operator*(const TensorExpression<Lhs_>& lhs, const TensorExpression<Rhs_>& rhs) {
+            return expression::binary_type<expression::Multiplies, Lhs_, Rhs_>(expression::make_node(lhs), expression::make_node(rhs));
+        }
+
+        template<typename Lhs_, typename Rhs_>
+        expression::binary_type<expression::Divides, Lhs_, Rhs_>
+        operator/(const TensorExpression<Lhs_>& lhs, const TensorExpression<Rhs_>& rhs) {
+            return expression::binary_type<expression::Divides, Lhs_, Rhs_>(expression::make_node(lhs), expression::make_node(rhs));
+        }
+
+        template<typename Expression_>
+        TensorUnaryExpression<expression::Negate, typename expression::node<Expression_>::type>
+        operator-(const TensorExpression<Expression_>& expr) {
+            return TensorUnaryExpression<expression::Negate, typename expression::node<Expression_>::type>(expression::make_node(expr));
+        }
+
+        template<typename Expression_, typename Scalar_>
+        expression::scalar_type<expression::Plus, Expression_, Scalar_, false>
+        operator+(const TensorExpression<Expression_>& expr, const Scalar_& scalar) {
+            return expression::scalar_type<expression::Plus, Expression_, Scalar_, false>(expression::make_node(expr), scalar);
+        }
+
+        template<typename Expression_, typename Scalar_>
+        expression::scalar_type<expression::Plus, Expression_, Scalar_, true>
+        operator+(const Scalar_& scalar, const TensorExpression<Expression_>& expr) {
+            return expression::scalar_type<expression::Plus, Expression_, Scalar_, true>(expression::make_node(expr), scalar);
+        }
+
+        template<typename Expression_, typename Scalar_>
+        expression::scalar_type<expression::Minus, Expression_, Scalar_, false>
+        operator-(const TensorExpression<Expression_>& expr, const Scalar_& scalar) {
+            return expression::scalar_type<expression::Minus, Expression_, Scalar_, false>(expression::make_node(expr), scalar);
+        }
+
+        template<typename Expression_, typename Scalar_>
+        expression::scalar_type<expression::Minus, Expression_, Scalar_, true>
+        operator-(const Scalar_& scalar, const TensorExpression<Expression_>& expr) {
+            return expression::scalar_type<expression::Minus, Expression_, Scalar_, true>(expression::make_node(expr), scalar);
+        }
+
+        template<typename Expression_, typename Scalar_>
+        expression::scalar_type<expression::Multiplies, Expression_, Scalar_, false>
+        operator*(const TensorExpression<Expression_>& expr, const Scalar_& scalar) {
+            return expression::scalar_type<expression::Multiplies, Expression_, Scalar_, false>(expression::make_node(expr), scalar);
+        }
+
+        template<typename Expression_, typename Scalar_>
+        expression::scalar_type<expression::Multiplies, Expression_, Scalar_, true>
+        operator*(const Scalar_& scalar, const TensorExpression<Expression_>& expr) {
+            return expression::scalar_type<expression::Multiplies, Expression_, Scalar_, true>(expression::make_node(expr), scalar);
+        }
+
+        template<typename Expression_, typename Scalar_>
+        expression::scalar_type<expression::Divides, Expression_, Scalar_, false>
+        operator/(const TensorExpression<Expression_>& expr, const Scalar_& scalar) {
+            return expression::scalar_type<expression::Divides, Expression_, Scalar_, false>(expression::make_node(expr), scalar);
+        }
+
+    }
+}
+
+#endif /* EM_MULTIDIM_TENSOR_EXPRESSION_HPP */
+
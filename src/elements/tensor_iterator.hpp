@@ -25,36 +25,57 @@
 #include <type_traits>
 
 #include "tensor.hpp"
+#include "tensor_view.hpp"
 #include "index_value_pair.hpp"
 
 namespace em {
     namespace element {
 
-        template<typename ValueType_, size_t rank_, StorageOrder order_, bool is_const_iterator_>
+        /**
+         * Random access iterator over a tensor like container (Tensor or 
+         * TensorView). Dereferencing provides the pair of the logical index
+         * and the reference to the value stored at that index.
+         * 
+         * The elements are traversed in the memory order of the container.
+         * The iterator carries the current logical index and the memory 
+         * offset and advances them like an odometer on increments, i.e.
+         * only the fastest changing dimension is touched unless it wraps.
+         * Arbitrary jumps (+=, -=, --) re-synchronize the state using the
+         * memory arranger.
+         * 
+         * The data pointer of the container is taken at construction, a
+         * non-const iterator obtained before Tensor::share() writes to the
+         * shared memory and should not be used afterwards.
+         */
+        template<typename ContainerType_, bool is_const_iterator_>
         class TensorIterator {
         protected:
-            typedef TensorIterator<ValueType_, rank_, order_, is_const_iterator_> Self_;
-            typedef typename std::conditional<is_const_iterator_, const Tensor<ValueType_, rank_, order_>, Tensor<ValueType_, rank_, order_>>::type TensorType_;
+            typedef TensorIterator<ContainerType_, is_const_iterator_> Self_;
+            typedef typename ContainerType_::data_type ValueType_;
+            typedef typename std::conditional<is_const_iterator_, const ContainerType_, ContainerType_>::type TensorType_;
             typedef TensorType_* TensorTypePtr_;
-            typedef Index<rank_> index_type;
+            typedef typename std::conditional<is_const_iterator_, const ValueType_*, ValueType_*>::type DataPtr_;
+            typedef typename ContainerType_::index_type index_type;
             typedef typename index_type::size_type size_type;
-            typedef MemoryArranger<rank_, order_> order_arranger_type;
+            typedef typename ContainerType_::arranger_type order_arranger_type;
 
         public:
-            static const size_t rank = rank_;
-            static const StorageOrder storage_order = order_;
+            static const size_t rank = ContainerType_::rank;
+            static const StorageOrder storage_order = ContainerType_::storage_order;
             using iterator_category = std::random_access_iterator_tag;
             using difference_type = std::ptrdiff_t;
-            using value_type = typename std::conditional<is_const_iterator_, IndexValuePair<const ValueType_, rank_>, IndexValuePair<ValueType_, rank_>>::type;
+            using value_type = typename std::conditional<is_const_iterator_, IndexValuePair<const ValueType_, rank>, IndexValuePair<ValueType_, rank>>::type;
             using pointer = value_type*;
             using reference = value_type&;
 
             TensorIterator()
-            : tensor_container_(), index_(0) {
+            : tensor_container_(), index_(0), size_(0), data_(nullptr), offset_(0) {
             }
 
             TensorIterator(TensorTypePtr_ base_ptr, size_type index)
-            : tensor_container_(base_ptr), index_(index) {
+            : tensor_container_(base_ptr), index_(index), size_(base_ptr->size()), data_(base_ptr->data()),
+              range_(base_ptr->range()), origin_(base_ptr->origin()), stride_(base_ptr->stride()), offset_(0) {
+                synchronize();
             }
 
             TensorIterator(const Self_& other) = default;
@@ -66,23 +87,24 @@ namespace em {
             Self_& operator=(const Self_& rhs) = default;
 
             reference operator*() {
-                rebook_pair(index_);
+                rebook_pair();
                 return pair_;
             }
 
             pointer operator->() {
-                rebook_pair(index_);
+                rebook_pair();
                 return &pair_;
             }
 
             Self_& operator++() {
                 index_++;
+                advance();
                 return *this;
             }
 
-            Self_ operator++(int increment) const {
+            Self_ operator++(int) {
                 Self_ temp = *this;
-                temp.index_ += increment;
+                ++(*this);
                 return temp;
             }
             
@@ -100,12 +122,13 @@ namespace em {
 
             Self_& operator--() {
                 index_--;
+                synchronize();
                 return *this;
             }
 
-            Self_ operator--(int decrement) const {
+            Self_ operator--(int) {
                 Self_ temp = *this;
-                temp.index_ -= decrement;
+                --(*this);
                 return temp;
             }
 
@@ -114,29 +137,32 @@ namespace em {
              */
 
             reference operator[](const difference_type& __n) const {
-                rebook_pair(index_ + __n);
+                Self_ temp = *this + __n;
+                pair_ = *temp;
                 return pair_;
             }
 
             Self_& operator+=(const difference_type& __n) {
                 index_ += __n;
+                synchronize();
                 return *this;
             }
 
             Self_ operator+(const difference_type& __n) const {
                 Self_ temp = *this;
-                temp.index_ += __n;
+                temp += __n;
                 return temp;
             }
 
             Self_& operator-=(const difference_type& __n) {
                 index_ -= __n;
+                synchronize();
                 return *this;
             }
 
             Self_ operator-(const difference_type& __n) const {
                 Self_ temp = *this;
-                temp.index_ -= __n;
+                temp -= __n;
                 return temp;
             }
 
@@ -150,58 +176,91 @@ namespace em {
 
         protected:
             
-            void rebook_pair(size_type index) {
-                index_type idx = order_arranger_type::map(index, tensor_container_->range(), tensor_container_->origin());
-                pair_ = value_type(idx, &tensor_container_->at(index));
+            /**
+             * Moves the logical index and the memory offset to the next
+             * element in the memory order
+             */
+            void advance() {
+                for (size_t n = 0; n < rank; ++n) {
+                    size_t dim = order_arranger_type::dimension(n);
+                    offset_ += stride_[dim];
+                    if (++current_[dim] < range_[dim] - origin_[dim]) return;
+                    
+                    //Wrap this dimension and carry to the next one
+                    current_[dim] = -origin_[dim];
+                    offset_ -= stride_[dim] * range_[dim];
+                }
+            }
+            
+            /**
+             * Recomputes the logical index and the memory offset from the
+             * position of the iterator
+             */
+            void synchronize() {
+                if (index_ >= size_) return;
+                current_ = order_arranger_type::map(index_, range_, origin_);
+                offset_ = 0;
+                for (size_t dim = 0; dim < rank; ++dim) offset_ += stride_[dim] * (current_[dim] + origin_[dim]);
+            }
+            
+            void rebook_pair() {
+                pair_ = value_type(current_, data_ + offset_);
             }
             
-            size_type index_;
             TensorTypePtr_ tensor_container_;
-            value_type pair_;
+            size_type index_;
+            size_type size_;
+            DataPtr_ data_;
+            index_type range_;
+            index_type origin_;
+            index_type stride_;
+            index_type current_;
+            difference_type offset_;
+            mutable value_type pair_;
 
         };
 
         // Random access iterator requirements
 
-        template<typename ValueType_, size_t rank_, StorageOrder order_, bool is_const_iterator_>
+        template<typename ContainerType_, bool is_const_iterator_>
         inline bool
-        operator<(const TensorIterator<ValueType_, rank_, order_, is_const_iterator_>& __lhs,
-                const TensorIterator<ValueType_, rank_, order_, is_const_iterator_>& __rhs) {
+        operator<(const TensorIterator<ContainerType_, is_const_iterator_>& __lhs,
+                const TensorIterator<ContainerType_, is_const_iterator_>& __rhs) {
             return __lhs.index() < __rhs.index();
         }
 
-        template<typename ValueType_, size_t rank_, StorageOrder order_, bool is_const_iterator_>
+        template<typename ContainerType_, bool is_const_iterator_>
         inline bool
-        operator>(const TensorIterator<ValueType_, rank_, order_, is_const_iterator_>& __lhs,
-                const TensorIterator<ValueType_, rank_, order_, is_const_iterator_>& __rhs) {
+        operator>(const TensorIterator<ContainerType_, is_const_iterator_>& __lhs,
+                const TensorIterator<ContainerType_, is_const_iterator_>& __rhs) {
             return __lhs.index() > __rhs.index();
         }
 
-        template<typename ValueType_, size_t rank_, StorageOrder order_, bool is_const_iterator_>
+        template<typename ContainerType_, bool is_const_iterator_>
         inline bool
-        operator<=(const TensorIterator<ValueType_, rank_, order_,is_const_iterator_>& __lhs,
-                const TensorIterator<ValueType_, rank_, order_, is_const_iterator_>& __rhs) {
+        operator<=(const TensorIterator<ContainerType_, is_const_iterator_>& __lhs,
+                const TensorIterator<ContainerType_, is_const_iterator_>& __rhs) {
             return __lhs.index() <= __rhs.index();
         }
 
-        template<typename ValueType_, size_t rank_, StorageOrder order_, bool is_const_iterator_>
+        template<typename ContainerType_, bool is_const_iterator_>
         inline bool
-        operator>=(const TensorIterator<ValueType_, rank_, order_, is_const_iterator_>& __lhs,
-                const TensorIterator<ValueType_, rank_, order_, is_const_iterator_>& __rhs) {
+        operator>=(const TensorIterator<ContainerType_, is_const_iterator_>& __lhs,
+                const TensorIterator<ContainerType_, is_const_iterator_>& __rhs) {
             return __lhs.index() >= __rhs.index();
         }
         
-        template<typename ValueType_, size_t rank_, StorageOrder order_, bool is_const_iterator_>
-        inline typename TensorIterator<ValueType_, rank_, order_, is_const_iterator_>::difference_type
-        operator-(const TensorIterator<ValueType_, rank_, order_,is_const_iterator_>& __lhs,
-                const TensorIterator<ValueType_, rank_, order_, is_const_iterator_>& __rhs) {
+        template<typename ContainerType_, bool is_const_iterator_>
+        inline typename TensorIterator<ContainerType_, is_const_iterator_>::difference_type
+        operator-(const TensorIterator<ContainerType_, is_const_iterator_>& __lhs,
+                const TensorIterator<ContainerType_, is_const_iterator_>& __rhs) {
             return __lhs.index() - __rhs.index();
         }
 
-        template<typename ValueType_, size_t rank_, StorageOrder order_, bool is_const_iterator_>
-        inline typename TensorIterator<ValueType_, rank_, order_, is_const_iterator_>::difference_type
-        operator+(const TensorIterator<ValueType_, rank_, order_,is_const_iterator_>& __lhs,
-                const TensorIterator<ValueType_, rank_, order_, is_const_iterator_>& __rhs) {
+        template<typename ContainerType_, bool is_const_iterator_>
+        inline typename TensorIterator<ContainerType_, is_const_iterator_>::difference_type
+        operator+(const TensorIterator<ContainerType_, is_const_iterator_>& __lhs,
+                const TensorIterator<ContainerType_, is_const_iterator_>& __rhs) {
             return __lhs.index() + __rhs.index();
         }
 
@@ -53,10 +53,18 @@ namespace em {
             static MemoryIdType map(const IndexType& idx, const IndexType& range, const IndexType& origin) {
                 return 0;
             }
+            
+            static MemoryIdType map(const IndexType& idx, const IndexType& range, const IndexType& origin, const IndexType& strides) {
+                return 0;
+            }
 
             static IndexType get_stride(const IndexType& range) {
                 return IndexType(0);
             }
+            
+            static size_t dimension(size_t n) {
+                return n;
+            }
 
 
         };
@@ -82,18 +90,35 @@ namespace em {
             };
 
             static MemoryIdType map(const IndexType& idx, const IndexType& range, const IndexType& origin) {
+                return map(idx, range, origin, get_stride(range));
+            };
+            
+            /**
+             * Maps the index to the memory id using the precomputed strides
+             * of the range. As the index is contained in the range and the
+             * origin is non-negative, the corrected index lies in (-range, 2*range)
+             * and can be brought back to [0, range) without a division.
+             */
+            static MemoryIdType map(const IndexType& idx, const IndexType& range, const IndexType& origin, const IndexType& strides) {
                 assert(range.contains(idx));
                 MemoryIdType memory_id = 0;
-                IndexType strides = get_stride(range);
-                IndexType corrected_index = idx + origin;
                 for (size_t i = 0; i < rank_; ++i) {
                     //Get the positive index
-                    size_t id_non_neg = (range[i] + corrected_index[i]) % range[i];
+                    MemoryIdType id_non_neg = idx[i] + origin[i];
+                    if (id_non_neg < 0) id_non_neg += range[i];
+                    else if (id_non_neg >= range[i]) id_non_neg -= range[i];
                     memory_id += strides[i] * id_non_neg;
                 }
                 return memory_id;
             };
 
+            /**
+             * Returns the n-th fastest changing dimension in the memory
+             */
+            static size_t dimension(size_t n) {
+                return n;
+            }
+
             static IndexType get_stride(const IndexType& range) {
                 IndexType strides(1);
                 if (range.rank > 1) {
@@ -129,18 +154,29 @@ namespace em {
             };
 
             static MemoryIdType map(const IndexType& idx, const IndexType& range, const IndexType& origin) {
+                return map(idx, range, origin, get_stride(range));
+            };
+            
+            static MemoryIdType map(const IndexType& idx, const IndexType& range, const IndexType& origin, const IndexType& strides) {
                 assert(range.contains(origin));
                 assert(range.contains(idx));
                 MemoryIdType memory_id = 0;
-                IndexType strides = get_stride(range);
-                IndexType corrected_index = idx + origin;
                 for (size_t i = 0; i < rank_; ++i) {
                     //Get the positive index
-                    int id_non_neg = (range[i] + corrected_index[i]) % range[i];
+                    MemoryIdType id_non_neg = idx[i] + origin[i];
+                    if (id_non_neg < 0) id_non_neg += range[i];
+                    else if (id_non_neg >= range[i]) id_non_neg -= range[i];
                     memory_id += strides[i] * id_non_neg;
                 }
                 return memory_id;
             };
+            
+            /**
+             * Returns the n-th fastest changing dimension in the memory
+             */
+            static size_t dimension(size_t n) {
+                return rank_ - 1 - n;
+            }
 
             static IndexType get_stride(const IndexType& range) {
                 IndexType strides;
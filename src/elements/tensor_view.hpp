@@ -0,0 +1,314 @@
+/* 
+ * This file is a part of emkit.
+ * 
+ * emkit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * emkit is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>
+ * 
+ * Author:
+ * Nikhil Biyani: nikhil(dot)biyani(at)gmail(dot)com
+ * 
+ */
+
+#ifndef EM_MULTIDIM_TENSOR_VIEW_HPP
+#define EM_MULTIDIM_TENSOR_VIEW_HPP
+
+#include <iostream>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <algorithm>
+#include <stdexcept>
+
+#include "tensor_storage_order.hpp"
+#include "index_value_pair.hpp"
+
+namespace em {
+    namespace element {
+
+        template<typename ContainerType_, bool is_const_iterator_>
+        class TensorIterator;
+
+        /**
+         * @brief       A non-owning view on the storage of a tensor
+         * @description The view does not hold any data, it only keeps a
+         *              pointer to the first element it refers to, its own
+         *              range and the strides with which the elements are
+         *              laid out in the memory of the parent. Slices, sections
+         *              and sub-boxes of a Tensor are provided as views, so
+         *              that they can be read and written in place.
+         *
+         *              The view behaves like a pointer, i.e. the constness
+         *              of the view does not propagate to the data. Use a
+         *              view with a const DataType_ for read only access.
+         *              The view is valid only as long as the parent storage
+         *              is neither destroyed nor resized.
+         */
+        template<typename DataType_, size_t rank_, StorageOrder order_>
+        class TensorView {
+        public:
+            static const int rank = rank_;
+            static const StorageOrder storage_order = order_;
+            using index_type = Index<rank_>;
+            using data_type = DataType_;
+            using arranger_type = MemoryArranger<rank_, order_>;
+
+            //For STL Random Access Iterator
+            using value_type = IndexValuePair<DataType_, rank_>;
+            using iterator = TensorIterator<TensorView<DataType_, rank_, order_>, false>;
+            using const_iterator = TensorIterator<TensorView<DataType_, rank_, order_>, true>;
+            using reference = DataType_&;
+            using const_reference = const DataType_&;
+            using pointer = typename std::add_pointer<DataType_>::type;
+            using difference_type = std::ptrdiff_t;
+            using size_type = typename Index<rank_>::size_type;
+
+        private:
+            using SelfType_ = TensorView<DataType_, rank_, order_>;
+
+        public:
+            /**
+             * Constructors
+             */
+
+            TensorView()
+            : data_(nullptr), range_(0), origin_(0), stride_(0) {
+            };
+
+            /**
+             * Constructs a view on the memory starting at data.
+             * @param data: pointer to the element with the physical index 0
+             * @param range: range of the view
+             * @param stride: memory distance between consecutive elements of each dimension
+             * @param origin: origin of the view
+             */
+            TensorView(pointer data, const index_type& range, const index_type& stride, const index_type& origin = index_type(0))
+            : data_(data), range_(range), origin_(origin), stride_(stride) {
+                assert(range.size() == 0 || range.contains(origin));
+            };
+
+            /**
+             * Conversion of a read-write view to a read only view
+             */
+            template<typename OtherDataType_,
+                     typename = typename std::enable_if<std::is_same<const OtherDataType_, DataType_>::value>::type>
+            TensorView(const TensorView<OtherDataType_, rank_, order_>& other)
+            : data_(other.data()), range_(other.range()), origin_(other.origin()), stride_(other.stride()) {
+            };
+
+            TensorView(const TensorView& other) = default;
+
+            TensorView& operator=(const TensorView& other) = default;
+
+
+            /**
+             * Element Access
+             */
+
+            reference operator[](const index_type& idx) const {
+                return data_[memory_offset(idx)];
+            }
+
+            reference at(const index_type& idx) const {
+                assert(range_.contains(idx));
+                return data_[memory_offset(idx)];
+            }
+
+            reference operator[](const size_type& idx) const {
+                return data_[memory_offset(idx)];
+            }
+
+            reference at(const size_type& idx) const {
+                assert(range_.size() > idx);
+                return data_[memory_offset(idx)];
+            }
+
+            pointer data() const {
+                return data_;
+            }
+
+
+            /**
+             * Iterators
+             */
+
+            iterator begin() {
+                return iterator(this, 0);
+            }
+
+            const_iterator begin() const {
+                return cbegin();
+            }
+
+            const_iterator cbegin() const {
+                return const_iterator(this, 0);
+            }
+
+            iterator end() {
+                return iterator(this, size());
+            }
+
+            const_iterator end() const {
+                return cend();
+            }
+
+            const_iterator cend() const {
+                return const_iterator(this, size());
+            }
+
+
+            /*
+             * Capacity
+             */
+
+            index_type range() const {
+                return range_;
+            }
+
+            index_type origin() const {
+                return origin_;
+            }
+
+            index_type stride() const {
+                return stride_;
+            }
+
+            size_type size() const {
+                return range_.size();
+            }
+
+            bool empty() const {
+                return data_ == nullptr || size() == 0;
+            }
+
+            /**
+             * Checks if the elements of the view are densely packed in the
+             * memory in the storage order of the view.
+             */
+            bool is_contiguous() const {
+                return stride_ == arranger_type::get_stride(range_);
+            }
+
+
+            /*
+             * Modifiers
+             */
+
+            /**
+             * Sets all the elements of the view to the given value
+             */
+            void fill(const typename std::remove_const<DataType_>::type& value) const {
+                if (is_contiguous()) std::fill(data_, data_ + size(), value);
+                else for (size_type id = 0; id < size(); ++id) (*this)[id] = value;
+            }
+
+            /**
+             * Copies the values from a tensor (or another view) of the same
+             * range into the memory referred by the view.
+             */
+            template<typename ContainerType_>
+            void assign(const ContainerType_& other) const {
+                assert(range_ == other.range());
+                if (origin_ == other.origin()) {
+                    //Same layout, walk both in memory order
+                    for (size_type id = 0; id < size(); ++id) (*this)[id] = other[id];
+                } else {
+                    for (const auto& itr : other) (*this)[itr.index()] = itr.value();
+                }
+            }
+
+
+            /**
+             * Slicing
+             */
+
+            TensorView<DataType_, rank_ - 1, order_> slice(typename index_type::value_type slice_number) const {
+                static_assert(rank_ > 1, "The rank should be more than 1 for slicing");
+                assert(slice_number < range_[rank_ - 1]);
+                Index < rank_ - 1 > slice_range, slice_stride, slice_origin;
+                for (int i = 0; i < rank_ - 1; ++i) {
+                    slice_range[i] = range_[i];
+                    slice_stride[i] = stride_[i];
+                    slice_origin[i] = origin_[i];
+                }
+                return TensorView<DataType_, rank_ - 1, order_>(data_ + slice_number * stride_[rank_ - 1], slice_range, slice_stride, slice_origin);
+            }
+
+
+            /**
+             * Sectioning
+             * The section is a view on the sub-box starting at the logical
+             * begin_index and with the range section_range. The sub-box has
+             * to be contiguous in memory: with a non-zero origin the logical
+             * indices wrap around the end of the memory, and a section 
+             * crossing that point (e.g. around the origin of a centered 
+             * object) throws std::out_of_range. Such a section can be 
+             * copied element by element with the logical indices instead.
+             */
+
+            SelfType_ section(const index_type& begin_index, const index_type& section_range) const {
+                index_type physical_begin;
+                for (int i = 0; i < rank_; ++i) {
+                    physical_begin[i] = ((begin_index[i] + origin_[i]) % range_[i] + range_[i]) % range_[i];
+                    if (section_range[i] < 0 || physical_begin[i] + section_range[i] > range_[i]) {
+                        throw std::out_of_range("TensorView: the section wraps around the memory or exceeds the range");
+                    }
+                }
+                difference_type offset = 0;
+                for (int i = 0; i < rank_; ++i) offset += physical_begin[i] * stride_[i];
+                return SelfType_(data_ + offset, section_range, stride_);
+            }
+
+
+            /**
+             * Output/Print
+             */
+            friend inline std::ostream& operator<<(std::ostream& os, const SelfType_& obj) {
+                for (const auto& itr : obj) {
+                    os << itr.index() << " -> " << itr.value() << "\n";
+                }
+                return os;
+            }
+
+        private:
+
+            /**
+             * Memory offset of the element with the logical index idx
+             */
+            difference_type memory_offset(const index_type& idx) const {
+                difference_type offset = 0;
+                for (size_t i = 0; i < rank_; ++i) {
+                    offset += stride_[i] * ((range_[i] + idx[i] + origin_[i]) % range_[i]);
+                }
+                return offset;
+            }
+
+            /**
+             * Memory offset of the element at the position id when the view
+             * is traversed in its storage order
+             */
+            difference_type memory_offset(const size_type& id) const {
+                index_type idx = arranger_type::map(id, range_, index_type(0));
+                difference_type offset = 0;
+                for (size_t i = 0; i < rank_; ++i) offset += stride_[i] * idx[i];
+                return offset;
+            }
+
+            pointer data_;
+            index_type range_;
+            index_type origin_;
+            index_type stride_;
+
+        };
+
+    }
+}
+
+#endif /* EM_MULTIDIM_TENSOR_VIEW_HPP */
+
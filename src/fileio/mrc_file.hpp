@@ -23,10 +23,14 @@
 #include <string>
 #include <fstream>
 #include <algorithm>
+#include <memory>
+#include <type_traits>
 
 #include "../modules/mrcfile/image.hpp"
 #include "../elements/file.hpp"
+#include "../elements/mapped_file.hpp"
 #include "../algorithm/fourier_transform.hpp"
+#include "../algorithm/convert.hpp"
 #include "../objects/object_base_types.hpp"
 
 namespace em {
@@ -64,13 +68,23 @@ namespace em {
                 int columns = std::stoi(mrc_image_.header().get("columns"));
                 int rows = std::stoi(mrc_image_.header().get("rows"));
                 int sections = std::stoi(mrc_image_.header().get("sections"));
+                index_type permutation;
+                bool reordered = false;
 
                 if (mode == 0 || mode == 1 || mode == 2) {
                     index_type range;
                     range[0] = columns;
                     range[1] = rows;
                     if (rank_ == 3) range[2] = sections;
-                    object = object_type(range, mrc_image_.data().get<data_type>());
+                    //The values are converted in a vector using the allocator of the object and moved in
+                    object = object_type(range, mrc_image_.data().get<data_type, typename object_type::allocator_type>());
+                    mrc_image_.data().clear();
+                    
+                    //Bring the axes stored in columns/rows/sections to x/y/z
+                    if (rank_ == 3 && axes_permutation(mrc_image_.header(), permutation)) {
+                        object = algorithm::permute_axes(object, permutation);
+                        reordered = true;
+                    }
 
                 } else if (mode == 3 || mode == 4) {
                     //THIS PART IS NOT TESTED
@@ -110,10 +124,84 @@ namespace em {
                     header_values.register_property(prop.first, prop.second);
                 }
                 
+                //The object is now stored with the default axes
+                if (reordered) {
+                    std::string starts[3] = {"nxstart", "nystart", "nzstart"};
+                    for (int i = 0; i < 3; ++i) {
+                        header_values.register_property(starts[i], mrc_image_.header().get(starts[permutation[i]]));
+                    }
+                    header_values.register_property("columns", std::to_string(object.range()[0]));
+                    header_values.register_property("rows", std::to_string(object.range()[1]));
+                    header_values.register_property("sections", std::to_string(object.range()[2]));
+                    header_values.register_property("mapc", "1");
+                    header_values.register_property("mapr", "2");
+                    header_values.register_property("maps", "3");
+                }
+                
                 mrc_image_.clear();
 
                 return true;
             }
+
+            /**
+             * Loads a real valued object on the data of the file mapped in
+             * memory instead of reading it. The pages are read from the file
+             * when they are accessed and the page cache is shared with the 
+             * other processes using the file, e.g. for particle stacks 
+             * larger than the memory.
+             * 
+             * The data is mapped if the object stores floats and the file
+             * has float values (mode 2) in the native byte order with the
+             * default axes. Otherwise the file is loaded as with load().
+             * 
+             * With READ_ONLY access the values are copied to the memory on
+             * the first write access to the object, with COPY_ON_WRITE only
+             * the written pages are copied. The file is never changed.
+             * If the file can not be mapped, a warning is printed and the
+             * file is loaded as with load().
+             */
+            template<typename ObjectType_>
+            bool load_mapped(ObjectType_& object, element::PropertiesMap& header_values,
+                    element::MappedFile::Access access = element::MappedFile::Access::READ_ONLY) {
+                using object_type = ObjectType_;
+                static const size_t rank_ = object::object_traits<ObjectType_>::rank;
+                using index_type = typename object::object_traits<ObjectType_>::index_type;
+                using data_type = typename object::object_traits<ObjectType_>::data_type;
+
+                if (!std::is_same<data_type, float>::value) return load(object, header_values);
+
+                mrc::Image mrc_image_ = get_mrc_image();
+                mrc_image_.load_header();
+                index_type permutation;
+                if (mrc_image_.header().mode() != 2 || mrc_image_.header().should_swap_endianness() 
+                        || (rank_ == 3 && axes_permutation(mrc_image_.header(), permutation))
+                        || mrc_image_.data_offset() % alignof(data_type) != 0) {
+                    return load(object, header_values);
+                }
+
+                index_type range;
+                range[0] = std::stoi(mrc_image_.header().get("columns"));
+                range[1] = std::stoi(mrc_image_.header().get("rows"));
+                if (rank_ == 3) range[2] = std::stoi(mrc_image_.header().get("sections"));
+                if (range.size() == 0) return load(object, header_values);
+
+                std::shared_ptr<element::MappedFile> mapping;
+                try {
+                    mapping = std::make_shared<element::MappedFile>(file_name(), mrc_image_.data_offset(), range.size() * sizeof (data_type), access);
+                } catch (const std::exception& error) {
+                    std::cerr << "WARNING: " << error.what() << ", loading it in memory instead.\n";
+                    return load(object, header_values);
+                }
+                std::shared_ptr<data_type> values(mapping, reinterpret_cast<data_type*> (mapping->data()));
+                object = object_type(range, values, mapping->is_writable());
+
+                //Copy the current properties
+                for (const auto& prop : mrc_image_.header().get_all()) {
+                    header_values.register_property(prop.first, prop.second);
+                }
+
+                return true;
+            }
             
 
             template<typename ObjectType_>
@@ -166,6 +254,24 @@ namespace em {
             }
 
         protected:
+            
+            /**
+             * Reads the axes (1: x, 2: y, 3: z) of the columns, rows and 
+             * sections from the header and deduces the permutation bringing
+             * them to x/y/z. 
+             * @return true if the axes are valid and not in the default order
+             */
+            template<typename IndexType_>
+            static bool axes_permutation(const mrc::Header& header, IndexType_& permutation) {
+                if (!header.exists("mapc") || !header.exists("mapr") || !header.exists("maps")) return false;
+                int axes[3] = {std::stoi(header.get("mapc")), std::stoi(header.get("mapr")), std::stoi(header.get("maps"))};
+                for (int file_axis = 0; file_axis < 3; ++file_axis) {
+                    if (axes[file_axis] < 1 || axes[file_axis] > 3) return false;
+                    permutation[axes[file_axis] - 1] = file_axis;
+                }
+                if (!element::is_permutation(permutation)) return false;
+                return !(axes[0] == 1 && axes[1] == 2 && axes[2] == 3);
+            }
 
             virtual mrc::Image get_mrc_image() const {
                 if (file_name() == "") {
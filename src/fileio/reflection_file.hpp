@@ -29,6 +29,7 @@
 #include "../elements/tensor.hpp"
 #include "../elements/string.hpp"
 #include "../elements/table.hpp"
+#include "../algorithm/convert.hpp"
 
 namespace em {
 
@@ -156,6 +157,7 @@ namespace em {
 
                 table.write_table(file_name_);
 
+                return true;
             }
 
             const std::string& file_name() const {
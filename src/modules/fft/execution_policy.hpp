@@ -0,0 +1,62 @@
+/* 
+ * Author: Nikhil Biyani - nikhil(dot)biyani(at)gmail(dot)com
+ *
+ * This file is a part of 2dx.
+ * 
+ * 2dx is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * 2dx is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FFT_EXECUTION_POLICY_HPP
+#define FFT_EXECUTION_POLICY_HPP
+
+#include "../../parallel/thread_budget.hpp"
+
+namespace em {
+    
+    namespace fft {
+        
+        /**
+         * Effort spent to find a fast plan for a transform size: ESTIMATE 
+         * plans heuristically, MEASURE and PATIENT time candidate plans 
+         * (more of them with PATIENT).
+         */
+        enum class PlanningRigor {
+            ESTIMATE, MEASURE, PATIENT
+        };
+        
+        /**
+         * How the transforms are executed: the number of threads of a 
+         * transform and the planning rigor. With 0 threads a transform 
+         * uses the share of a job in the ThreadBudget of the process, 
+         * hence transforms running in several application threads do not
+         * oversubscribe the machine.
+         */
+        struct ExecutionPolicy {
+            
+            ExecutionPolicy(int threads = 0, PlanningRigor rigor = PlanningRigor::MEASURE)
+            : threads(threads), rigor(rigor) {
+            }
+            
+            /**
+             * Number of threads used by a transform started now
+             */
+            int transform_threads() const {
+                return threads > 0 ? threads : (int) parallel::ThreadBudget::Instance().threads_per_job();
+            }
+            
+            int threads;
+            PlanningRigor rigor;
+        };
+    }
+}
+
+#endif /* FFT_EXECUTION_POLICY_HPP */
+
@@ -0,0 +1,129 @@
+/* 
+ * Author: Nikhil Biyani - nikhil(dot)biyani(at)gmail(dot)com
+ *
+ * This file is a part of 2dx.
+ * 
+ * 2dx is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * 2dx is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FFT_BACKENDS_HPP
+#define FFT_BACKENDS_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <functional>
+
+#include "fft_interface.hpp"
+#include "fourier_transform_native.hpp"
+#ifdef EM_USE_FFTW
+#include "fourier_transform_fftw.hpp"
+#endif
+
+namespace em {
+    
+    namespace fft {
+        
+        /**
+         * @brief       The registry of the implementations of FFTInterface
+         * @description A backend is registered with a name and a factory
+         *              creating its transformers with an execution policy.
+         *              The built-in transforms are registered as "native",
+         *              FFTW as "fftw" if emkit is built with it 
+         *              (EM_USE_FFTW). Other backends (e.g. for a GPU) are
+         *              added with add() and selected in the FFTEnvironment.
+         */
+        class FFTBackends {
+        public:
+            
+            using factory_type = std::function<std::shared_ptr<FFTInterface>(const ExecutionPolicy&)>;
+            
+            static FFTBackends& Instance() {
+                static FFTBackends instance;
+                return instance;
+            }
+            
+            FFTBackends(const FFTBackends&) = delete;
+            
+            FFTBackends& operator=(const FFTBackends&) = delete;
+            
+            /**
+             * The backend used by default, FFTW if available
+             */
+            static std::string default_name() {
+#ifdef EM_USE_FFTW
+                return "fftw";
+#else
+                return "native";
+#endif
+            }
+            
+            /**
+             * Registers a backend, replacing the one with the same name
+             */
+            void add(const std::string& name, const factory_type& factory) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                factories_[name] = factory;
+            }
+            
+            bool contains(const std::string& name) const {
+                std::lock_guard<std::mutex> lock(mutex_);
+                return factories_.find(name) != factories_.end();
+            }
+            
+            /**
+             * Names of the registered backends
+             */
+            std::vector<std::string> names() const {
+                std::lock_guard<std::mutex> lock(mutex_);
+                std::vector<std::string> result;
+                for (const auto& factory : factories_) result.push_back(factory.first);
+                return result;
+            }
+            
+            /**
+             * Creates a transformer of the backend
+             * @return nullptr if the backend is not registered
+             */
+            std::shared_ptr<FFTInterface> create(const std::string& name, const ExecutionPolicy& policy) const {
+                factory_type factory;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    auto found = factories_.find(name);
+                    if (found == factories_.end()) return nullptr;
+                    factory = found->second;
+                }
+                return factory(policy);
+            }
+            
+        private:
+            
+            FFTBackends() {
+                factories_["native"] = [](const ExecutionPolicy& policy) {
+                    return std::shared_ptr<FFTInterface>(new FourierTransformNative(policy));
+                };
+#ifdef EM_USE_FFTW
+                factories_["fftw"] = [](const ExecutionPolicy& policy) {
+                    return std::shared_ptr<FFTInterface>(new FourierTransformFFTW(policy));
+                };
+#endif
+            }
+            
+            std::map<std::string, factory_type> factories_;
+            mutable std::mutex mutex_;
+        };
+    }
+}
+
+#endif /* FFT_BACKENDS_HPP */
+
@@ -9,9 +9,17 @@
 #define FFT_ENVIRONMENT_HPP
 
 #include "fft_interface.hpp"
+#include "fft_backends.hpp"
+#ifdef EM_USE_FFTW
 #include "fourier_transform_fftw.hpp"
+#include "fftw_wisdom.hpp"
+#endif
 
 #include <memory>
+#include <string>
+#include <mutex>
+#include <cstdlib>
+#include <iostream>
 
 namespace em {
     namespace fft {
@@ -19,42 +27,179 @@ namespace em {
         /**
          * A singleton class to provide environment of the correct
          * FFT class using installation variables.
+         * 
+         * The transformers are created by a backend of the FFTBackends 
+         * registry, FFTW if emkit is built with it and the built-in 
+         * transforms otherwise. The backend is selected with the 
+         * environment variable EMKIT_FFT_BACKEND (e.g. "native") or with
+         * set_backend().
+         * 
+         * The FFTW wisdom is kept in the file given with the environment
+         * variable EMKIT_FFTW_WISDOM or with set_wisdom_file(). It is 
+         * loaded when the environment is created and saved when the 
+         * process exits if plans were created (see FFTWWisdom).
+         * 
+         * The transformers are created with the execution policy of the
+         * environment. By default a transform uses the share of its job in
+         * the parallel::ThreadBudget, hence applications running several
+         * transforms concurrently declare it with a 
+         * parallel::ConcurrencyScope.
          */
         class FFTEnvironment {
         public:
 
-            static FFTEnvironment Instance() {
+            static FFTEnvironment& Instance() {
                 static FFTEnvironment instance;
                 return instance;
             };
+            
+            FFTEnvironment(const FFTEnvironment&) = delete;
+            
+            FFTEnvironment& operator=(const FFTEnvironment&) = delete;
+            
+            ~FFTEnvironment() {
+#ifdef EM_USE_FFTW
+                if (!wisdom_file_.empty() && FFTWPlanCache::Instance().num_created() > 0) save_wisdom();
+#endif
+            }
 
             std::shared_ptr<FFTInterface> global_transformer() {
+                std::lock_guard<std::mutex> lock(mutex_);
                 return _transformer;
             };
             
+            /**
+             * Execution policy of the new transformers
+             */
+            ExecutionPolicy policy() const {
+                std::lock_guard<std::mutex> lock(mutex_);
+                return policy_;
+            }
+            
+            /**
+             * Sets the execution policy of the new transformers and of the
+             * global transformer
+             */
+            void set_policy(const ExecutionPolicy& policy) {
+                std::shared_ptr<FFTInterface> transformer = FFTBackends::Instance().create(backend(), policy);
+                std::lock_guard<std::mutex> lock(mutex_);
+                policy_ = policy;
+                _transformer = transformer;
+            }
+            
+            /**
+             * Name of the backend creating the transformers
+             */
+            std::string backend() const {
+                std::lock_guard<std::mutex> lock(mutex_);
+                return backend_;
+            }
+            
+            /**
+             * Selects the backend creating the new transformers and the 
+             * global transformer
+             * @return false if the backend is not registered
+             */
+            bool set_backend(const std::string& name) {
+                std::shared_ptr<FFTInterface> transformer = FFTBackends::Instance().create(name, policy());
+                if (!transformer) return false;
+                std::lock_guard<std::mutex> lock(mutex_);
+                backend_ = name;
+                _transformer = transformer;
+                return true;
+            }
+            
+            /**
+             * Creates a transformer. The plans are shared by all the 
+             * transformers of a backend (e.g. through the FFTWPlanCache), 
+             * so creating one is cheap.
+             */
             static std::shared_ptr<FFTInterface> new_transformer() {
-                //The default transformer
-                return std::shared_ptr<FFTInterface>(new FourierTransformFFTW());
-#ifdef TDX_USE_CUDA
-                //Use CUDA counterpart of the Fourier transform.
-#endif
+                return new_transformer(Instance().policy());
+            }
+            
+            static std::shared_ptr<FFTInterface> new_transformer(const ExecutionPolicy& policy) {
+                return FFTBackends::Instance().create(Instance().backend(), policy);
             }
             
+            /**
+             * Creates a transformer with the transforms of the sizes 
+             * prepared
+             */
             static std::shared_ptr<FFTInterface> new_transformer(const std::vector<int>& sizes) {
-                //The default transformer
-                return std::shared_ptr<FFTInterface>(new FourierTransformFFTW(sizes));
-#ifdef TDX_USE_CUDA
-                //Use CUDA counterpart of the Fourier transform.
+                std::shared_ptr<FFTInterface> transformer = new_transformer();
+                transformer->prepare(sizes);
+                return transformer;
+            }
+
+            /**
+             * Sets the file of the FFTW wisdom and loads it
+             * @param file: empty to not use a wisdom file
+             * @return false if the wisdom could not be loaded
+             */
+            bool set_wisdom_file(const std::string& file) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    wisdom_file_ = file;
+                }
+                return load_wisdom();
+            }
+            
+            std::string wisdom_file() const {
+                std::lock_guard<std::mutex> lock(mutex_);
+                return wisdom_file_;
+            }
+            
+            /**
+             * Imports the wisdom from the wisdom file
+             * @return false without FFTW
+             */
+            bool load_wisdom() {
+#ifdef EM_USE_FFTW
+                std::string file = wisdom_file();
+                return !file.empty() && FFTWWisdom::load(file);
+#else
+                return false;
+#endif
+            }
+            
+            /**
+             * Exports the wisdom of the process to the wisdom file
+             * @return false without FFTW
+             */
+            bool save_wisdom() {
+#ifdef EM_USE_FFTW
+                std::string file = wisdom_file();
+                return !file.empty() && FFTWWisdom::save(file);
+#else
+                return false;
 #endif
             }
 
         private:
 
-            FFTEnvironment() {
-                _transformer = new_transformer();
+            FFTEnvironment()
+            : backend_(FFTBackends::default_name()) {
+#ifdef EM_USE_FFTW
+                //The plan cache has to outlive the environment saving its wisdom
+                FFTWPlanCache::Instance();
+#endif
+                const char* env = std::getenv("EMKIT_FFTW_WISDOM");
+                if (env != nullptr) set_wisdom_file(env);
+                
+                const char* backend = std::getenv("EMKIT_FFT_BACKEND");
+                if (backend != nullptr) {
+                    if (FFTBackends::Instance().contains(backend)) backend_ = backend;
+                    else std::cerr << "WARNING: Unknown FFT backend '" << backend << "', using " << backend_ << "\n";
+                }
+                _transformer = FFTBackends::Instance().create(backend_, policy_);
             };
             
             std::shared_ptr<FFTInterface> _transformer;
+            ExecutionPolicy policy_;
+            std::string backend_;
+            std::string wisdom_file_;
+            mutable std::mutex mutex_;
         };
     }
 }
@@ -17,23 +17,259 @@
 #ifndef FOURIER_TRANSFORMER_HPP_AX89
 #define FOURIER_TRANSFORMER_HPP_AX89
 
+#include <cstddef>
+#include <cassert>
 #include <vector>
+#include <algorithm>
+
+#include "../../elements/aligned_allocator.hpp"
+#include "execution_policy.hpp"
+#include "fft_layout.hpp"
 
 namespace em {
     
     namespace fft {
+        
+        /**
+         * Vector of doubles with the memory aligned as required by the
+         * SIMD instructions (and by FFTW for executing the plans directly
+         * on the memory). This is the storage used by the double 
+         * precision tensors.
+         */
+        using AlignedVector = std::vector<double, element::AlignedAllocator<double>>;
 
         /**
          * An abstract class (interface) to provide Fourier transform method.
+         * 
+         * The transforms work on raw memory so that the tensors can be
+         * transformed without intermediate copies. The complex data is 
+         * interleaved (real, imaginary) in column major order with the 
+         * x dimension trimmed to sizes[0]/2+1. The forward transform is
+         * normalized by 1/sqrt(N) and conjugated, the inverse transform
+         * undoes both, hence a forward followed by an inverse transform
+         * gives back the input.
+         * 
+         * The transforms are executed with the ExecutionPolicy of the 
+         * transformer (threads per transform and planning rigor).
          */
         class FFTInterface {
         public:
+            
+            FFTInterface(const ExecutionPolicy& policy = ExecutionPolicy())
+            : policy_(policy) {
+            }
+            
+            virtual ~FFTInterface() {
+            }
+            
+            const ExecutionPolicy& policy() const {
+                return policy_;
+            }
+            
+            void set_policy(const ExecutionPolicy& policy) {
+                policy_ = policy;
+            }
+            
+            /**
+             * Prepares the transforms of the given sizes (e.g. creates 
+             * their plans) so that the first transform is not slowed down.
+             * Nothing is done by default.
+             */
+            virtual void prepare(const std::vector<int>&) {
+            }
+            
+            /**
+             * Number of real values of a transform with the given sizes
+             */
+            static size_t real_size(const std::vector<int>& sizes) {
+                size_t size = 1;
+                for (int extent : sizes) size *= extent;
+                return size;
+            }
+            
+            /**
+             * Number of complex values of a transform with the given sizes
+             */
+            static size_t complex_size(const std::vector<int>& sizes) {
+                if (sizes.empty() || sizes[0] == 0) return 0;
+                return (real_size(sizes) / sizes[0]) * (sizes[0] / 2 + 1);
+            }
+
+            /**
+             * Forward Fourier transform of the memory. The normalization 
+             * and the conjugation are applied while the output is written.
+             * @param sizes: sizes of the real data, x being the fastest
+             * @param[in] real: real_size(sizes) values, not modified
+             * @param[out] complex: complex_size(sizes)*2 values, not 
+             *                      overlapping the input
+             */
+            virtual void forward_fourier(const std::vector<int>& sizes, const double* real, double* complex) = 0;
+
+            /**
+             * Inverse Fourier transform of the memory. 
+             * @param sizes: sizes of the real data, x being the fastest
+             * @param[in] complex: complex_size(sizes)*2 values, not 
+             *                     modified
+             * @param[out] real: real_size(sizes) values, not overlapping 
+             *                   the input
+             */
+            virtual void inverse_fourier(const std::vector<int>& sizes, const double* complex, double* real) = 0;
+            
+            /**
+             * Single precision forward Fourier transform of the memory. 
+             * Transformers without a single precision implementation 
+             * transform a double precision copy.
+             */
+            virtual void forward_fourier(const std::vector<int>& sizes, const float* real, float* complex) {
+                AlignedVector real_data(real, real + real_size(sizes));
+                AlignedVector complex_data(complex_size(sizes)*2);
+                forward_fourier(sizes, real_data.data(), complex_data.data());
+                std::copy(complex_data.begin(), complex_data.end(), complex);
+            }
+
+            /**
+             * Single precision inverse Fourier transform of the memory. 
+             * Transformers without a single precision implementation 
+             * transform a double precision copy.
+             */
+            virtual void inverse_fourier(const std::vector<int>& sizes, const float* complex, float* real) {
+                AlignedVector complex_data(complex, complex + complex_size(sizes)*2);
+                AlignedVector real_data(real_size(sizes));
+                inverse_fourier(sizes, complex_data.data(), real_data.data());
+                std::copy(real_data.begin(), real_data.end(), real);
+            }
+            
+            /**
+             * Forward Fourier transforms of a batch of consecutive arrays 
+             * of the sizes (e.g. the images of a stack). By default the
+             * arrays are transformed one after the other.
+             * @param sizes: sizes of one real array, x being the fastest
+             * @param batch: number of arrays
+             * @param[in] real: batch*real_size(sizes) values
+             * @param[out] complex: batch*complex_size(sizes)*2 values
+             */
+            virtual void forward_fourier_batch(const std::vector<int>& sizes, size_t batch, const double* real, double* complex) {
+                transform_batch(sizes, batch, real, complex, [this](const std::vector<int>& s, const double* in, double* out) {
+                    forward_fourier(s, in, out);
+                });
+            }
+            
+            /**
+             * Inverse Fourier transforms of a batch of consecutive arrays
+             * @param sizes: sizes of one real array, x being the fastest
+             * @param batch: number of arrays
+             * @param[in] complex: batch*complex_size(sizes)*2 values
+             * @param[out] real: batch*real_size(sizes) values
+             */
+            virtual void inverse_fourier_batch(const std::vector<int>& sizes, size_t batch, const double* complex, double* real) {
+                inverse_batch(sizes, batch, complex, real, [this](const std::vector<int>& s, const double* in, double* out) {
+                    inverse_fourier(s, in, out);
+                });
+            }
+            
+            /**
+             * Single precision forward transforms of a batch
+             */
+            virtual void forward_fourier_batch(const std::vector<int>& sizes, size_t batch, const float* real, float* complex) {
+                transform_batch(sizes, batch, real, complex, [this](const std::vector<int>& s, const float* in, float* out) {
+                    forward_fourier(s, in, out);
+                });
+            }
+            
+            /**
+             * Single precision inverse transforms of a batch
+             */
+            virtual void inverse_fourier_batch(const std::vector<int>& sizes, size_t batch, const float* complex, float* real) {
+                inverse_batch(sizes, batch, complex, real, [this](const std::vector<int>& s, const float* in, float* out) {
+                    inverse_fourier(s, in, out);
+                });
+            }
+            
+            /**
+             * Forward transforms of a batch written in a centered layout:
+             * the zero frequency of every transform is stored at the 
+             * origin and the other frequencies are circularly shifted 
+             * around it (as in a ComplexHalfObject). By default the 
+             * transforms are shifted in a second pass.
+             * @param origin: position of the zero frequency in the 
+             *                complex values of a transform (x fastest)
+             */
+            virtual void forward_fourier_batch(const std::vector<int>& sizes, size_t batch, const double* real, double* complex, const std::vector<int>& origin) {
+                forward_centered(sizes, batch, real, complex, origin);
+            }
+            
+            /**
+             * Inverse transforms of a batch stored in a centered layout 
+             * (see above). By default the transforms are shifted back in
+             * a first pass.
+             */
+            virtual void inverse_fourier_batch(const std::vector<int>& sizes, size_t batch, const double* complex, double* real, const std::vector<int>& origin) {
+                inverse_centered(sizes, batch, complex, real, origin);
+            }
+            
+            virtual void forward_fourier_batch(const std::vector<int>& sizes, size_t batch, const float* real, float* complex, const std::vector<int>& origin) {
+                forward_centered(sizes, batch, real, complex, origin);
+            }
+            
+            virtual void inverse_fourier_batch(const std::vector<int>& sizes, size_t batch, const float* complex, float* real, const std::vector<int>& origin) {
+                inverse_centered(sizes, batch, complex, real, origin);
+            }
+            
+            /**
+             * Complex to complex forward Fourier transform of the memory. 
+             * The transform has the normalization and the sign of the 
+             * conjugated real transforms, i.e. the transform of a complex
+             * array with no imaginary part is the full version of the 
+             * output of forward_fourier().
+             * @param sizes: sizes of the complex data, x being the fastest
+             * @param[in] input: real_size(sizes)*2 interleaved values
+             * @param[out] output: real_size(sizes)*2 values, the transform
+             *                     is done in place if it is the input
+             * @param origin: position of the zero frequency in the output
+             *                (see forward_fourier_batch()), should be zero 
+             *                for the transforms in place
+             */
+            virtual void forward_complex_fourier(const std::vector<int>& sizes, const double* input, double* output, const std::vector<int>& origin) = 0;
+            
+            /**
+             * Complex to complex inverse Fourier transform of the memory
+             * @param sizes: sizes of the complex data, x being the fastest
+             * @param[in] input: real_size(sizes)*2 interleaved values
+             * @param[out] output: real_size(sizes)*2 values, the transform
+             *                     is done in place if it is the input
+             * @param origin: position of the zero frequency in the input,
+             *                should be zero for the transforms in place
+             */
+            virtual void inverse_complex_fourier(const std::vector<int>& sizes, const double* input, double* output, const std::vector<int>& origin) = 0;
+            
+            /**
+             * Single precision complex to complex forward transform. 
+             * Transformers without a single precision implementation 
+             * transform a double precision copy.
+             */
+            virtual void forward_complex_fourier(const std::vector<int>& sizes, const float* input, float* output, const std::vector<int>& origin) {
+                AlignedVector input_data(input, input + real_size(sizes)*2);
+                AlignedVector output_data(real_size(sizes)*2);
+                forward_complex_fourier(sizes, input_data.data(), output_data.data(), origin);
+                std::copy(output_data.begin(), output_data.end(), output);
+            }
+            
+            /**
+             * Single precision complex to complex inverse transform. 
+             * Transformers without a single precision implementation 
+             * transform a double precision copy.
+             */
+            virtual void inverse_complex_fourier(const std::vector<int>& sizes, const float* input, float* output, const std::vector<int>& origin) {
+                AlignedVector input_data(input, input + real_size(sizes)*2);
+                AlignedVector output_data(real_size(sizes)*2);
+                inverse_complex_fourier(sizes, input_data.data(), output_data.data(), origin);
+                std::copy(output_data.begin(), output_data.end(), output);
+            }
+            
             /**
              * A method which provides a Fourier transform on the input and generates
              * the output
-             * @param nx
-             * @param ny
-             * @param nz
+             * @param sizes
              * @param[in] input: All the real space data in column major order
              * @param[out] output: Column major order with size of (nz*ny(nx/2+1)*2) 
              *                     where each even index in x 0,2,4,.. 
@@ -41,13 +277,16 @@ namespace em {
              *                     and each odd index in x: 1,3,5,..
              *                     provides values of imaginary coefficients.   
              */
-            virtual std::vector<double> forward_fourier(const std::vector<int>& sizes, const std::vector<double>& input) = 0;
+            virtual AlignedVector forward_fourier(const std::vector<int>& sizes, const AlignedVector& input) {
+                assert(input.size() >= real_size(sizes));
+                AlignedVector output(complex_size(sizes)*2);
+                forward_fourier(sizes, input.data(), output.data());
+                return output;
+            }
 
             /* A method which provides a inverse Fourier transform on the input and generates
              * the output
-             * @param nx
-             * @param ny
-             * @param nz
+             * @param sizes
              * @param[in] input: Column major order with size of (nz*ny(nx/2+1)*2) 
              *                     where each even index in x 0,2,4,.. 
              *                     provides values of real coefficients.
@@ -55,9 +294,71 @@ namespace em {
              *                     provides values of imaginary coefficients. 
              * @param[out] output: All the density values in column major order  
              */
-            virtual std::vector<double> inverse_fourier(const std::vector<int>& sizes, const std::vector<double>& input) = 0;
+            virtual AlignedVector inverse_fourier(const std::vector<int>& sizes, const AlignedVector& input) {
+                assert(input.size() >= complex_size(sizes)*2);
+                AlignedVector output(real_size(sizes));
+                inverse_fourier(sizes, input.data(), output.data());
+                return output;
+            }
 
 
+        protected:
+            
+            ExecutionPolicy policy_;
+            
+            /**
+             * Transforms the real arrays of the batch one after the other
+             */
+            template<typename ValueType_, typename Transform_>
+            static void transform_batch(const std::vector<int>& sizes, size_t batch, const ValueType_* real, ValueType_* complex, const Transform_& transform) {
+                for (size_t id = 0; id < batch; ++id) {
+                    transform(sizes, real + id * real_size(sizes), complex + id * complex_size(sizes) * 2);
+                }
+            }
+            
+            /**
+             * Forward transforms of the batch shifted in the centered layout
+             */
+            template<typename ValueType_>
+            void forward_centered(const std::vector<int>& sizes, size_t batch, const ValueType_* real, ValueType_* complex, const std::vector<int>& origin) {
+                if (is_zero(origin)) {
+                    forward_fourier_batch(sizes, batch, real, complex);
+                    return;
+                }
+                std::vector<ValueType_, element::AlignedAllocator<ValueType_>> buffer(batch * complex_size(sizes) * 2);
+                forward_fourier_batch(sizes, batch, real, buffer.data());
+                shifted_copy(as_complex(buffer.data()), as_complex(complex), complex_range(sizes, batch), origin, [](const std::complex<ValueType_>& value) {
+                    return value;
+                });
+            }
+            
+            /**
+             * Inverse transforms of the batch shifted back from the centered
+             * layout
+             */
+            template<typename ValueType_>
+            void inverse_centered(const std::vector<int>& sizes, size_t batch, const ValueType_* complex, ValueType_* real, const std::vector<int>& origin) {
+                if (is_zero(origin)) {
+                    inverse_fourier_batch(sizes, batch, complex, real);
+                    return;
+                }
+                std::vector<ValueType_, element::AlignedAllocator<ValueType_>> buffer(batch * complex_size(sizes) * 2);
+                shifted_copy(as_complex(complex), as_complex(buffer.data()), complex_range(sizes, batch), opposite(origin), [](const std::complex<ValueType_>& value) {
+                    return value;
+                });
+                inverse_fourier_batch(sizes, batch, buffer.data(), real);
+            }
+            
+            /**
+             * Transforms the complex arrays of the batch one after the other
+             */
+            template<typename ValueType_, typename Transform_>
+            static void inverse_batch(const std::vector<int>& sizes, size_t batch, const ValueType_* complex, ValueType_* real, const Transform_& transform) {
+                for (size_t id = 0; id < batch; ++id) {
+                    transform(sizes, complex + id * complex_size(sizes) * 2, real + id * real_size(sizes));
+                }
+            }
+
         };
     }
 }
@@ -0,0 +1,142 @@
+/* 
+ * Author: Nikhil Biyani - nikhil(dot)biyani(at)gmail(dot)com
+ *
+ * This file is a part of 2dx.
+ * 
+ * 2dx is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * 2dx is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FFT_LAYOUT_HPP
+#define FFT_LAYOUT_HPP
+
+#include <cstddef>
+#include <vector>
+#include <complex>
+#include <algorithm>
+
+#include "../../parallel/parallel_algorithm.hpp"
+
+namespace em {
+    
+    namespace fft {
+        
+        /**
+         * Range (x fastest) of the complex values of a batch of transforms
+         * of the given sizes, the last dimension being the batch.
+         */
+        inline std::vector<size_t> complex_range(const std::vector<int>& sizes, size_t batch) {
+            std::vector<size_t> range(sizes.begin(), sizes.end());
+            if (!range.empty()) range[0] = range[0] / 2 + 1;
+            range.push_back(batch);
+            return range;
+        }
+        
+        /**
+         * Range (x fastest) of the values of a batch of complex to complex 
+         * transforms of the given sizes, the last dimension being the batch.
+         */
+        inline std::vector<size_t> full_range(const std::vector<int>& sizes, size_t batch) {
+            std::vector<size_t> range(sizes.begin(), sizes.end());
+            range.push_back(batch);
+            return range;
+        }
+        
+        /**
+         * Checks if an origin (or a shift) has no effect
+         */
+        inline bool is_zero(const std::vector<int>& origin) {
+            return std::all_of(origin.begin(), origin.end(), [](int value) {
+                return value == 0;
+            });
+        }
+        
+        /**
+         * Shift moving a centered layout back to the lower left corner
+         */
+        inline std::vector<int> opposite(const std::vector<int>& origin) {
+            std::vector<int> shift(origin.size());
+            for (size_t dim = 0; dim < origin.size(); ++dim) shift[dim] = -origin[dim];
+            return shift;
+        }
+        
+        /**
+         * Interleaved (real, imaginary) values seen as complex numbers
+         */
+        template<typename RealType_>
+        std::complex<RealType_>* as_complex(RealType_* values) {
+            return reinterpret_cast<std::complex<RealType_>*> (values);
+        }
+        
+        template<typename RealType_>
+        const std::complex<RealType_>* as_complex(const RealType_* values) {
+            return reinterpret_cast<const std::complex<RealType_>*> (values);
+        }
+        
+        /**
+         * @brief       Copies a column major array applying an operation on
+         *              the values and shifting them circularly, i.e. 
+         *              output[(p + shift) mod range] = operation(input[p]).
+         * @description This is used to write the transforms directly in the
+         *              centered layout of the ComplexHalfObject (and to read
+         *              them back) together with the normalization in a 
+         *              single pass. Every row along the fastest dimension 
+         *              goes to its shifted row, the rows are processed in 
+         *              parallel.
+         * @param       input
+         * @param       output: not overlapping the input
+         * @param       range: x fastest
+         * @param       shift: shift of the first dimensions of the range,
+         *              (can be negative), missing ones are not shifted
+         * @param       operation
+         */
+        template<typename ValueType_, typename Operation_>
+        void shifted_copy(const ValueType_* input, ValueType_* output, const std::vector<size_t>& range, 
+                const std::vector<int>& shift, const Operation_& operation) {
+            size_t total = 1;
+            for (size_t extent : range) total *= extent;
+            if (total == 0) return;
+            
+            const size_t rank = range.size();
+            std::vector<size_t> stride(rank), distance(rank, 0);
+            for (size_t dim = 0, size = 1; dim < rank; size *= range[dim], ++dim) {
+                stride[dim] = size;
+                if (dim < shift.size()) {
+                    const std::ptrdiff_t extent = range[dim];
+                    distance[dim] = (size_t) (((shift[dim] % extent) + extent) % extent);
+                }
+            }
+            
+            const size_t length = range[0];
+            const size_t split = length - distance[0];
+            parallel::parallel_for(total / length, std::max<size_t>(1, parallel::block_size<ValueType_>() / length), [&](size_t begin, size_t end) {
+                for (size_t row = begin; row < end; ++row) {
+                    //Position of the shifted row
+                    size_t remainder = row;
+                    size_t target = 0;
+                    for (size_t dim = 1; dim < rank; ++dim) {
+                        size_t position = remainder % range[dim] + distance[dim];
+                        remainder /= range[dim];
+                        if (position >= range[dim]) position -= range[dim];
+                        target += position * stride[dim];
+                    }
+                    
+                    const ValueType_* source = input + row * length;
+                    ValueType_* destination = output + target;
+                    for (size_t x = 0; x < split; ++x) destination[x + distance[0]] = operation(source[x]);
+                    for (size_t x = split; x < length; ++x) destination[x - split] = operation(source[x]);
+                }
+            });
+        }
+    }
+}
+
+#endif /* FFT_LAYOUT_HPP */
+
@@ -0,0 +1,55 @@
+/* 
+ * Author: Nikhil Biyani - nikhil(dot)biyani(at)gmail(dot)com
+ *
+ * This file is a part of 2dx.
+ * 
+ * 2dx is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * 2dx is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FFT_SIZE_HPP
+#define FFT_SIZE_HPP
+
+#include <cstddef>
+
+namespace em {
+    
+    namespace fft {
+        
+        /**
+         * Checks if the size has no prime factor other than 2, 3, 5 and 7,
+         * the sizes FFTW has codelets for. The native backend has dedicated
+         * butterflies for the radices 2, 3, 4 and 5 only, a factor 7 uses 
+         * its generic butterfly which costs O(7^2) per group of 7 values
+         * but stays far cheaper than a larger prime factor.
+         */
+        inline bool is_good_size(size_t size) {
+            if (size == 0) return false;
+            for (size_t factor : {2, 3, 5, 7}) {
+                while (size % factor == 0) size /= factor;
+            }
+            return size == 1;
+        }
+        
+        /**
+         * Smallest good size (2^a 3^b 5^c 7^d) not smaller than the given 
+         * size. With even, the size is also a multiple of 2, as preferred 
+         * for the first dimension of the real transforms.
+         */
+        inline size_t good_size(size_t size, bool even = false) {
+            size_t candidate = size < 1 ? 1 : size;
+            while (!is_good_size(candidate) || (even && candidate % 2 != 0)) ++candidate;
+            return candidate;
+        }
+        
+    }
+}
+
+#endif /* FFT_SIZE_HPP */
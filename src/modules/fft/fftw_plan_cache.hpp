@@ -0,0 +1,561 @@
+/* 
+ * Author: Nikhil Biyani - nikhil(dot)biyani(at)gmail(dot)com
+ *
+ * This file is a part of 2dx.
+ * 
+ * 2dx is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * 2dx is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FFTW_PLAN_CACHE_HPP
+#define FFTW_PLAN_CACHE_HPP
+
+#include <cstdio>
+#include <cassert>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <tuple>
+
+#include <fftw3.h>
+
+#include "execution_policy.hpp"
+
+namespace em {
+    
+    namespace fft {
+        
+        enum class Direction {
+            FORWARD, INVERSE
+        };
+        
+        enum class Precision {
+            DOUBLE, SINGLE
+        };
+        
+        /**
+         * Domain of the transformed arrays: REAL for the real to complex
+         * (forward) and complex to real (inverse) transforms, COMPLEX for 
+         * the complex to complex transforms.
+         */
+        enum class Domain {
+            REAL, COMPLEX
+        };
+        
+        /**
+         * Maps the FFTW functions of a precision (fftw_ for double, fftwf_
+         * for float) to common names.
+         */
+        template<typename RealType_>
+        struct FFTWTraits;
+        
+        template<>
+        struct FFTWTraits<double> {
+            using real_type = double;
+            using complex_type = fftw_complex;
+            using plan_type = fftw_plan;
+            static const Precision precision = Precision::DOUBLE;
+            
+            static void init_threads() {
+                fftw_init_threads();
+            }
+            
+            static void plan_with_nthreads(int threads) {
+                fftw_plan_with_nthreads(threads);
+            }
+            
+            static plan_type plan_r2c(int rank, const int* n, real_type* in, complex_type* out, unsigned flags) {
+                return fftw_plan_dft_r2c(rank, n, in, out, flags);
+            }
+            
+            static plan_type plan_c2r(int rank, const int* n, complex_type* in, real_type* out, unsigned flags) {
+                return fftw_plan_dft_c2r(rank, n, in, out, flags);
+            }
+            
+            static plan_type plan_many_r2c(int rank, const int* n, int howmany, real_type* in, int idist, complex_type* out, int odist, unsigned flags) {
+                return fftw_plan_many_dft_r2c(rank, n, howmany, in, nullptr, 1, idist, out, nullptr, 1, odist, flags);
+            }
+            
+            static plan_type plan_many_c2r(int rank, const int* n, int howmany, complex_type* in, int idist, real_type* out, int odist, unsigned flags) {
+                return fftw_plan_many_dft_c2r(rank, n, howmany, in, nullptr, 1, idist, out, nullptr, 1, odist, flags);
+            }
+            
+            static plan_type plan_c2c(int rank, const int* n, complex_type* in, complex_type* out, int sign, unsigned flags) {
+                return fftw_plan_dft(rank, n, in, out, sign, flags);
+            }
+            
+            static void execute_r2c(plan_type plan, real_type* in, complex_type* out) {
+                fftw_execute_dft_r2c(plan, in, out);
+            }
+            
+            static void execute_c2r(plan_type plan, complex_type* in, real_type* out) {
+                fftw_execute_dft_c2r(plan, in, out);
+            }
+            
+            static void execute_c2c(plan_type plan, complex_type* in, complex_type* out) {
+                fftw_execute_dft(plan, in, out);
+            }
+            
+            static void destroy_plan(plan_type plan) {
+                fftw_destroy_plan(plan);
+            }
+            
+            static real_type* alloc_real(size_t n) {
+                return fftw_alloc_real(n);
+            }
+            
+            static complex_type* alloc_complex(size_t n) {
+                return fftw_alloc_complex(n);
+            }
+            
+            static void free(void* memory) {
+                fftw_free(memory);
+            }
+            
+            static int alignment_of(const real_type* memory) {
+                return fftw_alignment_of(const_cast<real_type*>(memory));
+            }
+            
+            static int import_wisdom(FILE* file) {
+                return fftw_import_wisdom_from_file(file);
+            }
+            
+            static void export_wisdom(FILE* file) {
+                fftw_export_wisdom_to_file(file);
+            }
+        };
+        
+#ifdef EM_USE_FFTWF
+        /**
+         * Single precision (fftwf_), available if the library is linked
+         * with fftw3f.
+         */
+        template<>
+        struct FFTWTraits<float> {
+            using real_type = float;
+            using complex_type = fftwf_complex;
+            using plan_type = fftwf_plan;
+            static const Precision precision = Precision::SINGLE;
+            
+            static void init_threads() {
+                fftwf_init_threads();
+            }
+            
+            static void plan_with_nthreads(int threads) {
+                fftwf_plan_with_nthreads(threads);
+            }
+            
+            static plan_type plan_r2c(int rank, const int* n, real_type* in, complex_type* out, unsigned flags) {
+                return fftwf_plan_dft_r2c(rank, n, in, out, flags);
+            }
+            
+            static plan_type plan_c2r(int rank, const int* n, complex_type* in, real_type* out, unsigned flags) {
+                return fftwf_plan_dft_c2r(rank, n, in, out, flags);
+            }
+            
+            static plan_type plan_many_r2c(int rank, const int* n, int howmany, real_type* in, int idist, complex_type* out, int odist, unsigned flags) {
+                return fftwf_plan_many_dft_r2c(rank, n, howmany, in, nullptr, 1, idist, out, nullptr, 1, odist, flags);
+            }
+            
+            static plan_type plan_many_c2r(int rank, const int* n, int howmany, complex_type* in, int idist, real_type* out, int odist, unsigned flags) {
+                return fftwf_plan_many_dft_c2r(rank, n, howmany, in, nullptr, 1, idist, out, nullptr, 1, odist, flags);
+            }
+            
+            static plan_type plan_c2c(int rank, const int* n, complex_type* in, complex_type* out, int sign, unsigned flags) {
+                return fftwf_plan_dft(rank, n, in, out, sign, flags);
+            }
+            
+            static void execute_r2c(plan_type plan, real_type* in, complex_type* out) {
+                fftwf_execute_dft_r2c(plan, in, out);
+            }
+            
+            static void execute_c2r(plan_type plan, complex_type* in, real_type* out) {
+                fftwf_execute_dft_c2r(plan, in, out);
+            }
+            
+            static void execute_c2c(plan_type plan, complex_type* in, complex_type* out) {
+                fftwf_execute_dft(plan, in, out);
+            }
+            
+            static void destroy_plan(plan_type plan) {
+                fftwf_destroy_plan(plan);
+            }
+            
+            static real_type* alloc_real(size_t n) {
+                return fftwf_alloc_real(n);
+            }
+            
+            static complex_type* alloc_complex(size_t n) {
+                return fftwf_alloc_complex(n);
+            }
+            
+            static void free(void* memory) {
+                fftwf_free(memory);
+            }
+            
+            static int alignment_of(const real_type* memory) {
+                return fftwf_alignment_of(const_cast<real_type*>(memory));
+            }
+            
+            static int import_wisdom(FILE* file) {
+                return fftwf_import_wisdom_from_file(file);
+            }
+            
+            static void export_wisdom(FILE* file) {
+                fftwf_export_wisdom_to_file(file);
+            }
+        };
+        
+#endif
+
+        /**
+         * Identifies a plan by the sizes of the real space (x fastest), 
+         * the direction (forward: real to complex, inverse: complex to 
+         * real), the precision, the number of threads used by FFTW, the 
+         * number of transforms of consecutive arrays done by the plan,
+         * the planning rigor, the domain and, for complex to complex 
+         * plans, if the transform is done in place.
+         */
+        struct PlanKey {
+            std::vector<int> sizes;
+            Direction direction;
+            Precision precision;
+            int threads;
+            int batch;
+            PlanningRigor rigor;
+            Domain domain;
+            bool in_place;
+            
+            size_t rank() const {
+                return sizes.size();
+            }
+            
+            /**
+             * Number of values in the real space of one transform
+             */
+            size_t transform_size() const {
+                size_t size = 1;
+                for (int s : sizes) size *= s;
+                return size;
+            }
+            
+            /**
+             * Number of complex values in the half of the Fourier space of
+             * one transform, or in the full space for the complex domain
+             */
+            size_t transform_complex_size() const {
+                if (sizes.empty()) return 0;
+                if (domain == Domain::COMPLEX) return transform_size();
+                return (transform_size() / sizes[0]) * (sizes[0] / 2 + 1);
+            }
+            
+            /**
+             * Number of values in the real space of all the transforms
+             */
+            size_t real_size() const {
+                return transform_size() * batch;
+            }
+            
+            /**
+             * Number of complex values of all the transforms
+             */
+            size_t complex_size() const {
+                return transform_complex_size() * batch;
+            }
+            
+            bool operator<(const PlanKey& other) const {
+                return std::tie(sizes, direction, precision, threads, batch, rigor, domain, in_place) 
+                        < std::tie(other.sizes, other.direction, other.precision, other.threads, other.batch, other.rigor, other.domain, other.in_place);
+            }
+        };
+        
+        /**
+         * Mutex to be held while using the FFTW planner (creating and 
+         * destroying plans), which is not thread safe.
+         */
+        inline std::mutex& planner_mutex() {
+            static std::mutex mutex;
+            return mutex;
+        }
+        
+        /**
+         * @brief       An execute-only handle of a FFTW plan
+         * @description The plan is executed on the arrays given at each 
+         *              call with the new-array execute functions, which can
+         *              be called from several threads at the same time. The
+         *              arrays should have the alignment of the memory from
+         *              fftw_malloc (as the tensors and AlignedVector), 
+         *              otherwise the data is staged through aligned arrays.
+         */
+        template<typename RealType_>
+        class FFTWPlan {
+        public:
+            using traits_type = FFTWTraits<RealType_>;
+            using real_type = RealType_;
+            using complex_type = typename traits_type::complex_type;
+            using plan_type = typename traits_type::plan_type;
+            
+            /**
+             * Creates the plan with the FFTW flag of the planning rigor. 
+             * Batches are planned with the advanced interface (plan_many)
+             * on consecutive arrays. Should be called while holding the 
+             * planner_mutex().
+             */
+            FFTWPlan(const PlanKey& key) 
+            : key_(key), plan_(nullptr) {
+                std::vector<int> n(key.sizes.rbegin(), key.sizes.rend());
+                if (key.domain == Domain::COMPLEX) {
+                    plan_complex(n);
+                    return;
+                }
+                real_type* real = traits_type::alloc_real(std::max<size_t>(1, key.real_size()));
+                complex_type* complex = traits_type::alloc_complex(std::max<size_t>(1, key.complex_size()));
+                alignment_ = traits_type::alignment_of(real);
+                traits_type::plan_with_nthreads(key.threads);
+                const unsigned flags = planner_flags(key.rigor);
+                const int real_distance = (int) key.transform_size();
+                const int complex_distance = (int) key.transform_complex_size();
+                if (key.batch > 1) {
+                    if (key.direction == Direction::FORWARD) plan_ = traits_type::plan_many_r2c((int) n.size(), n.data(), key.batch, real, real_distance, complex, complex_distance, flags);
+                    else plan_ = traits_type::plan_many_c2r((int) n.size(), n.data(), key.batch, complex, complex_distance, real, real_distance, flags);
+                }
+                else if (key.direction == Direction::FORWARD) plan_ = traits_type::plan_r2c((int) n.size(), n.data(), real, complex, flags);
+                else plan_ = traits_type::plan_c2r((int) n.size(), n.data(), complex, real, flags);
+                traits_type::free(real);
+                traits_type::free(complex);
+            }
+            
+            /**
+             * Destroys the plan. Should be called while holding the
+             * planner_mutex().
+             */
+            ~FFTWPlan() {
+                if (plan_ != nullptr) traits_type::destroy_plan(plan_);
+            }
+            
+            FFTWPlan(const FFTWPlan&) = delete;
+            
+            FFTWPlan& operator=(const FFTWPlan&) = delete;
+            
+            const PlanKey& key() const {
+                return key_;
+            }
+            
+            /**
+             * Forward transform of key().real_size() values into 
+             * key().complex_size() complex values. The input is not changed.
+             */
+            void execute_r2c(const real_type* real, complex_type* complex) const {
+                if (is_compatible(real, complex)) {
+                    traits_type::execute_r2c(plan_, const_cast<real_type*>(real), complex);
+                    return;
+                }
+                real_type* staged_real = traits_type::alloc_real(key_.real_size());
+                complex_type* staged_complex = traits_type::alloc_complex(key_.complex_size());
+                std::copy(real, real + key_.real_size(), staged_real);
+                traits_type::execute_r2c(plan_, staged_real, staged_complex);
+                std::copy(reinterpret_cast<real_type*>(staged_complex), reinterpret_cast<real_type*>(staged_complex + key_.complex_size()), reinterpret_cast<real_type*>(complex));
+                traits_type::free(staged_real);
+                traits_type::free(staged_complex);
+            }
+            
+            /**
+             * Complex to complex transform of key().complex_size() values.
+             * The input is the output for the plans in place, otherwise it
+             * is not changed.
+             */
+            void execute_c2c(const complex_type* input, complex_type* output) const {
+                assert(key_.in_place == (input == output));
+                const real_type* input_values = reinterpret_cast<const real_type*>(input);
+                if (is_compatible(input_values, output)) {
+                    traits_type::execute_c2c(plan_, const_cast<complex_type*>(input), output);
+                    return;
+                }
+                const size_t size = key_.complex_size();
+                complex_type* staged_input = traits_type::alloc_complex(size);
+                complex_type* staged_output = key_.in_place ? staged_input : traits_type::alloc_complex(size);
+                std::copy(input_values, input_values + 2*size, reinterpret_cast<real_type*>(staged_input));
+                traits_type::execute_c2c(plan_, staged_input, staged_output);
+                std::copy(reinterpret_cast<real_type*>(staged_output), reinterpret_cast<real_type*>(staged_output + size), reinterpret_cast<real_type*>(output));
+                if (!key_.in_place) traits_type::free(staged_output);
+                traits_type::free(staged_input);
+            }
+            
+            /**
+             * Inverse transform of key().complex_size() complex values into
+             * key().real_size() values. The input is overwritten.
+             */
+            void execute_c2r(complex_type* complex, real_type* real) const {
+                if (is_compatible(real, complex)) {
+                    traits_type::execute_c2r(plan_, complex, real);
+                    return;
+                }
+                real_type* staged_real = traits_type::alloc_real(key_.real_size());
+                complex_type* staged_complex = traits_type::alloc_complex(key_.complex_size());
+                std::copy(reinterpret_cast<real_type*>(complex), reinterpret_cast<real_type*>(complex + key_.complex_size()), reinterpret_cast<real_type*>(staged_complex));
+                traits_type::execute_c2r(plan_, staged_complex, staged_real);
+                std::copy(staged_real, staged_real + key_.real_size(), real);
+                traits_type::free(staged_real);
+                traits_type::free(staged_complex);
+            }
+            
+        private:
+            
+            /**
+             * Creates a complex to complex plan. The forward transform has
+             * the positive exponent (FFTW_BACKWARD) so that it matches the
+             * conjugated output of the real transforms.
+             */
+            void plan_complex(std::vector<int>& n) {
+                const size_t size = std::max<size_t>(1, key_.complex_size());
+                complex_type* input = traits_type::alloc_complex(size);
+                complex_type* output = key_.in_place ? input : traits_type::alloc_complex(size);
+                alignment_ = traits_type::alignment_of(reinterpret_cast<real_type*>(input));
+                traits_type::plan_with_nthreads(key_.threads);
+                const int sign = (key_.direction == Direction::FORWARD) ? FFTW_BACKWARD : FFTW_FORWARD;
+                plan_ = traits_type::plan_c2c((int) n.size(), n.data(), input, output, sign, planner_flags(key_.rigor));
+                if (!key_.in_place) traits_type::free(output);
+                traits_type::free(input);
+            }
+            
+            static unsigned planner_flags(PlanningRigor rigor) {
+                switch (rigor) {
+                    case PlanningRigor::ESTIMATE: return FFTW_ESTIMATE;
+                    case PlanningRigor::PATIENT: return FFTW_PATIENT;
+                    default: return FFTW_MEASURE;
+                }
+            }
+            
+            bool is_compatible(const real_type* real, const complex_type* complex) const {
+                return traits_type::alignment_of(real) == alignment_
+                    && traits_type::alignment_of(reinterpret_cast<const real_type*>(complex)) == alignment_;
+            }
+            
+            PlanKey key_;
+            plan_type plan_;
+            int alignment_;
+        };
+        
+        /**
+         * @brief       A process wide cache of the FFTW plans
+         * @description The plans are created once for each key and shared
+         *              by all the transformers and threads, so that the 
+         *              images of a stack are planned only once. Looking up 
+         *              a plan is thread safe, the planning is serialized 
+         *              with the planner_mutex().
+         */
+        class FFTWPlanCache {
+        public:
+            
+            static FFTWPlanCache& Instance() {
+                static FFTWPlanCache instance;
+                return instance;
+            }
+            
+            FFTWPlanCache(const FFTWPlanCache&) = delete;
+            
+            FFTWPlanCache& operator=(const FFTWPlanCache&) = delete;
+            
+            /**
+             * The plan for the given sizes (x fastest) and direction,
+             * created on the first request with the threads and the rigor
+             * of the policy. A batch plan transforms several consecutive 
+             * arrays of the sizes.
+             */
+            template<typename RealType_>
+            std::shared_ptr<const FFTWPlan<RealType_>> plan(const std::vector<int>& sizes, Direction direction, const ExecutionPolicy& policy = ExecutionPolicy(), int batch = 1) {
+                PlanKey key = {sizes, direction, FFTWTraits<RealType_>::precision, policy.transform_threads(), batch, policy.rigor, Domain::REAL, false};
+                return find_or_create<RealType_>(key);
+            }
+            
+            /**
+             * The complex to complex plan for the given sizes (x fastest)
+             * and direction, in place or out of place.
+             */
+            template<typename RealType_>
+            std::shared_ptr<const FFTWPlan<RealType_>> complex_plan(const std::vector<int>& sizes, Direction direction, const ExecutionPolicy& policy, bool in_place) {
+                PlanKey key = {sizes, direction, FFTWTraits<RealType_>::precision, policy.transform_threads(), 1, policy.rigor, Domain::COMPLEX, in_place};
+                return find_or_create<RealType_>(key);
+            }
+            
+            /**
+             * Number of plans in the cache
+             */
+            size_t size() const {
+                std::lock_guard<std::mutex> lock(mutex_);
+                return plans_.size();
+            }
+            
+            /**
+             * Number of plans created since the start of the process
+             */
+            size_t num_created() const {
+                std::lock_guard<std::mutex> lock(mutex_);
+                return num_created_;
+            }
+            
+            /**
+             * Removes all the plans from the cache. The handles in use 
+             * stay valid.
+             */
+            void clear() {
+                std::map<PlanKey, std::shared_ptr<const void>> plans;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    plans.swap(plans_);
+                }
+            }
+            
+        private:
+            
+            FFTWPlanCache()
+            : num_created_(0) {
+                //The planner mutex has to outlive the cached plans
+                planner_mutex();
+            }
+            
+            template<typename RealType_>
+            std::shared_ptr<const FFTWPlan<RealType_>> find_or_create(const PlanKey& key) {
+                using traits_type = FFTWTraits<RealType_>;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    auto found = plans_.find(key);
+                    if (found != plans_.end()) return std::static_pointer_cast<const FFTWPlan<RealType_>>(found->second);
+                }
+                
+                std::lock_guard<std::mutex> planner_lock(planner_mutex());
+                static bool threads_initialized = (traits_type::init_threads(), true);
+                (void) threads_initialized;
+                
+                //The plan could have been created while waiting for the planner
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto found = plans_.find(key);
+                if (found != plans_.end()) return std::static_pointer_cast<const FFTWPlan<RealType_>>(found->second);
+                
+                std::shared_ptr<const FFTWPlan<RealType_>> created(new FFTWPlan<RealType_>(key), [](const FFTWPlan<RealType_>* plan) {
+                    std::lock_guard<std::mutex> planner_lock(planner_mutex());
+                    delete plan;
+                });
+                plans_[key] = created;
+                ++num_created_;
+                return created;
+            }
+            
+            std::map<PlanKey, std::shared_ptr<const void>> plans_;
+            size_t num_created_;
+            mutable std::mutex mutex_;
+        };
+    }
+}
+
+#endif /* FFTW_PLAN_CACHE_HPP */
+
@@ -0,0 +1,148 @@
+/* 
+ * Author: Nikhil Biyani - nikhil(dot)biyani(at)gmail(dot)com
+ *
+ * This file is a part of 2dx.
+ * 
+ * 2dx is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * 2dx is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FFTW_WISDOM_HPP
+#define FFTW_WISDOM_HPP
+
+#include <cstdio>
+#include <string>
+#include <mutex>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+
+#include <fftw3.h>
+
+#include "fftw_plan_cache.hpp"
+
+namespace em {
+    
+    namespace fft {
+        
+        /**
+         * @brief       Persistent storage of the FFTW wisdom
+         * @description The wisdom (the plans measured by FFTW) is written
+         *              to a file and read back by the next processes, which
+         *              then create their plans without measuring them. The
+         *              double precision wisdom is stored in the file, the
+         *              single precision one in the file with the suffix
+         *              ".single".
+         *              
+         *              The file can be shared by concurrent jobs: it is read
+         *              under a shared lock and written under an exclusive 
+         *              lock (flock). Before writing, the wisdom already in
+         *              the file is merged into the process, so the plans
+         *              measured by other jobs are kept.
+         */
+        class FFTWWisdom {
+        public:
+            
+            /**
+             * Imports the wisdom from the file
+             * @return false if the file does not exist or is not valid
+             */
+            static bool load(const std::string& file) {
+                bool loaded = load_precision<double>(file);
+#ifdef EM_USE_FFTWF
+                load_precision<float>(file + ".single");
+#endif
+                return loaded;
+            }
+            
+            /**
+             * Exports the wisdom of the process to the file, merged with 
+             * the wisdom already in the file
+             * @return false if the file can not be written
+             */
+            static bool save(const std::string& file) {
+                bool saved = save_precision<double>(file);
+#ifdef EM_USE_FFTWF
+                saved = save_precision<float>(file + ".single") && saved;
+#endif
+                return saved;
+            }
+            
+        private:
+            
+            /**
+             * A file locked with flock while it is open
+             */
+            class LockedFile {
+            public:
+                
+                LockedFile(const std::string& name, bool writable)
+                : file_(nullptr) {
+                    int descriptor = writable ? ::open(name.c_str(), O_RDWR | O_CREAT, 0644) : ::open(name.c_str(), O_RDONLY);
+                    if (descriptor < 0) return;
+                    if (::flock(descriptor, writable ? LOCK_EX : LOCK_SH) != 0 || (file_ = ::fdopen(descriptor, writable ? "r+" : "r")) == nullptr) {
+                        ::close(descriptor);
+                    }
+                }
+                
+                ~LockedFile() {
+                    //Closing the file releases the lock
+                    if (file_ != nullptr) std::fclose(file_);
+                }
+                
+                LockedFile(const LockedFile&) = delete;
+                
+                LockedFile& operator=(const LockedFile&) = delete;
+                
+                FILE* get() const {
+                    return file_;
+                }
+                
+                bool is_empty() const {
+                    return std::fseek(file_, 0, SEEK_END) != 0 || std::ftell(file_) <= 0;
+                }
+                
+            private:
+                FILE* file_;
+            };
+            
+            template<typename RealType_>
+            static bool load_precision(const std::string& name) {
+                LockedFile file(name, false);
+                if (file.get() == nullptr || file.is_empty()) return false;
+                std::rewind(file.get());
+                std::lock_guard<std::mutex> planner_lock(planner_mutex());
+                return FFTWTraits<RealType_>::import_wisdom(file.get()) != 0;
+            }
+            
+            template<typename RealType_>
+            static bool save_precision(const std::string& name) {
+                LockedFile file(name, true);
+                if (file.get() == nullptr) return false;
+                std::lock_guard<std::mutex> planner_lock(planner_mutex());
+                
+                //Merge the wisdom saved by the other processes
+                if (!file.is_empty()) {
+                    std::rewind(file.get());
+                    FFTWTraits<RealType_>::import_wisdom(file.get());
+                }
+                
+                std::rewind(file.get());
+                if (::ftruncate(::fileno(file.get()), 0) != 0) return false;
+                FFTWTraits<RealType_>::export_wisdom(file.get());
+                return std::fflush(file.get()) == 0;
+            }
+        };
+    }
+}
+
+#endif /* FFTW_WISDOM_HPP */
+
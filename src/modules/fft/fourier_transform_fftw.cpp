@@ -14,196 +14,227 @@
  * License for more details <http://www.gnu.org/licenses/>.
  */
 
+#include <cassert>
 #include <vector>
 #include <algorithm>
-#include <thread>
-#include <mutex>
 
 #include "fourier_transform_fftw.hpp"
+#include "../../parallel/parallel_algorithm.hpp"
 
 using namespace em::fft;
 
-std::mutex FourierTransformFFTW::mutex_;
+FourierTransformFFTW::FourierTransformFFTW(const ExecutionPolicy& policy)
+: FFTInterface(policy)
+{
+}
 
-FourierTransformFFTW::FourierTransformFFTW()
+FourierTransformFFTW::FourierTransformFFTW(const std::vector<int>& sizes, const ExecutionPolicy& policy)
+: FFTInterface(policy)
 {
-    sizes_ = std::vector<int>();
-    _initialized = false;
-    
-    //Initialize the threaded environment in FFTW
-    fftw_init_threads();
-    
-    //Set maximum number of threads
-    fftw_plan_with_nthreads(std::thread::hardware_concurrency());
+    prepare(sizes);
 }
 
-FourierTransformFFTW::FourierTransformFFTW(const std::vector<int>& sizes)
+void FourierTransformFFTW::prepare(const std::vector<int>& sizes)
 {
-    sizes_ = sizes;
-    _initialized = false;
-    
-    //Initialize the threaded environment in FFTW
-    fftw_init_threads();
-    
-    //Set maximum number of threads
-    fftw_plan_with_nthreads(std::thread::hardware_concurrency());
-    
     //Create plans
-    create_plans();
+    FFTWPlanCache::Instance().plan<double>(sizes, Direction::FORWARD, policy_);
+    FFTWPlanCache::Instance().plan<double>(sizes, Direction::INVERSE, policy_);
 }
 
-FourierTransformFFTW::FourierTransformFFTW(const FourierTransformFFTW& copy)
+double FourierTransformFFTW::normalization_factor(const std::vector<int>& sizes)
 {
-    reset(copy);
+    if(real_size(sizes) < 1) return 1;
+    else {
+        return 1.0/sqrt((double)real_size(sizes));
+    }
 }
 
-FourierTransformFFTW::~FourierTransformFFTW()
+template<typename Real_>
+size_t FourierTransformFFTW::group_size(const std::vector<int>& sizes, size_t batch)
 {
-    clear();
+    const size_t bytes = std::max<size_t>(1, complex_size(sizes) * 2 * sizeof(Real_));
+    return std::max<size_t>(1, std::min(batch, kBatchBytes / bytes));
 }
 
-void FourierTransformFFTW::reset(const FourierTransformFFTW& copy)
-{  
-    if(sizes_ != copy.sizes_)
+template<typename Real_>
+void FourierTransformFFTW::execute_forward(const std::vector<int>& sizes, size_t batch, const Real_* real, Real_* complex, const std::vector<int>& origin) const
+{
+    using complex_type = typename FFTWPlan<Real_>::complex_type;
+    const size_t group = group_size<Real_>(sizes, batch);
+    const Real_ factor = (Real_) normalization_factor(sizes);
+    const bool centered = !is_zero(origin);
+    
+    //Transforms written in the centered layout go through a buffer
+    std::vector<Real_, em::element::AlignedAllocator<Real_>> staged(centered ? group*complex_size(sizes)*2 : 0);
+    
+    for(size_t first=0; first<batch; first+=group)
     {
-        sizes_ = copy.sizes_;
+        const size_t count = std::min(group, batch - first);
+        auto plan = FFTWPlanCache::Instance().plan<Real_>(sizes, Direction::FORWARD, policy_, (int) count);
+        const PlanKey& key = plan->key();
+        Real_* output = complex + 2*first*key.transform_complex_size();
         
-        clear();
+        //The out of place r2c transforms do not overwrite the input.
+        plan->execute_r2c(real + first*key.transform_size(), (complex_type*) (centered ? staged.data() : output));
         
-        if(copy._initialized)
-        {
-            create_plans();
+        //Normalize, conjugate and shift in a single pass
+        if (centered) {
+            shifted_copy(as_complex(staged.data()), as_complex(output), complex_range(sizes, count), origin, [factor](const std::complex<Real_>& value) {
+                return std::complex<Real_>(value.real() * factor, -value.imag() * factor);
+            });
+        } else {
+            em::parallel::parallel_for(key.complex_size(), em::parallel::block_size<complex_type>(), [&](size_t begin, size_t end) {
+                for(size_t id=begin; id<end; id++)
+                {
+                    output[2*id] *= factor;
+                    output[2*id+1] *= -factor;
+                }
+            });
         }
     }
-    
 }
 
-void FourierTransformFFTW::clear()
+template<typename Real_>
+void FourierTransformFFTW::execute_inverse(const std::vector<int>& sizes, size_t batch, const Real_* complex, Real_* real, const std::vector<int>& origin) const
 {
-    if(_initialized)
+    using complex_type = typename FFTWPlan<Real_>::complex_type;
+    const size_t group = group_size<Real_>(sizes, batch);
+    const Real_ factor = (Real_) normalization_factor(sizes);
+    std::vector<Real_, em::element::AlignedAllocator<Real_>> staged(group*complex_size(sizes)*2);
+    const std::vector<int> shift = opposite(origin);
+    
+    for(size_t first=0; first<batch; first+=group)
     {
+        const size_t count = std::min(group, batch - first);
+        auto plan = FFTWPlanCache::Instance().plan<Real_>(sizes, Direction::INVERSE, policy_, (int) count);
+        const PlanKey& key = plan->key();
+        const Real_* input = complex + 2*first*key.transform_complex_size();
         
-        fftw_free(_real_data);
-        fftw_free(_complex_data);
-        fftw_destroy_plan(_plan_r2c);
-        fftw_destroy_plan(_plan_c2r);
-        
+        //Normalize, conjugate and shift back to the FFTW layout in a single
+        //pass. The c2r transforms overwrite their input, hence the complex
+        //data is staged anyway.
+        shifted_copy(as_complex(input), as_complex(staged.data()), complex_range(sizes, count), shift, [factor](const std::complex<Real_>& value) {
+            return std::complex<Real_>(value.real() * factor, -value.imag() * factor);
+        });
+
+        plan->execute_c2r((complex_type*) staged.data(), real + first*key.transform_size());
     }
-    _initialized = false;
 }
 
-void FourierTransformFFTW::create_plans()
+template<typename Real_>
+void FourierTransformFFTW::execute_complex(const std::vector<int>& sizes, Direction direction, const Real_* input, Real_* output, const std::vector<int>& origin) const
 {
-    //std::cout << "Creating plans\n";
-    mutex_.lock();
-    clear();
-    _real_data = fftw_alloc_real(real_size());
-    _complex_data =  fftw_alloc_complex(fourier_size());
+    using complex_type = typename FFTWPlan<Real_>::complex_type;
+    const size_t size = real_size(sizes);
+    const Real_ factor = (Real_) normalization_factor(sizes);
+    const bool in_place = (input == output);
+    const bool centered = !is_zero(origin);
+    assert(!(in_place && centered));
+    auto normalize = [factor](const std::complex<Real_>& value) {
+        return value * factor;
+    };
+    
+    if (centered && direction == Direction::INVERSE) {
+        //The output stages the normalized input shifted back to the lower
+        //left corner, which is then transformed in place
+        shifted_copy(as_complex(input), as_complex(output), full_range(sizes, 1), opposite(origin), normalize);
+        auto plan = FFTWPlanCache::Instance().complex_plan<Real_>(sizes, direction, policy_, true);
+        plan->execute_c2c((complex_type*) output, (complex_type*) output);
+        return;
+    }
     
-    _plan_r2c = fftw_plan(fftw_plan_dft_r2c(sizes_.size(), reversed_sizes().data(), _real_data, _complex_data, FFTW_MEASURE));
-    _plan_c2r = fftw_plan(fftw_plan_dft_c2r(sizes_.size(), reversed_sizes().data(), _complex_data, _real_data, FFTW_MEASURE));
-    _initialized = true;
-    mutex_.unlock();
+    auto plan = FFTWPlanCache::Instance().complex_plan<Real_>(sizes, direction, policy_, in_place);
+    if (centered) {
+        //Normalize and shift in a single pass
+        std::vector<Real_, em::element::AlignedAllocator<Real_>> staged(size*2);
+        plan->execute_c2c((const complex_type*) input, (complex_type*) staged.data());
+        shifted_copy(as_complex(staged.data()), as_complex(output), full_range(sizes, 1), origin, normalize);
+        return;
+    }
     
-    //std::cout << "Finished creating plans\n";
+    plan->execute_c2c((const complex_type*) input, (complex_type*) output);
+    em::parallel::parallel_for(size*2, em::parallel::block_size<Real_>(), [&](size_t begin, size_t end) {
+        for(size_t id=begin; id<end; id++) output[id] *= factor;
+    });
 }
 
-FourierTransformFFTW& FourierTransformFFTW::operator=(const FourierTransformFFTW& rhs)
+void FourierTransformFFTW::forward_fourier(const std::vector<int>& sizes, const double* real, double* complex)
 {
-    reset(rhs);
-    return *this;
+    execute_forward(sizes, 1, real, complex, std::vector<int>());
 }
 
-std::vector<int> FourierTransformFFTW::reversed_sizes() const {
-    std::vector<int> rev = sizes_;
-    std::reverse(rev.begin(), rev.end());
-    return rev;
+void FourierTransformFFTW::inverse_fourier(const std::vector<int>& sizes, const double* complex, double* real)
+{
+    execute_inverse(sizes, 1, complex, real, std::vector<int>());
 }
 
-size_t FourierTransformFFTW::real_size() const
+void FourierTransformFFTW::forward_fourier_batch(const std::vector<int>& sizes, size_t batch, const double* real, double* complex)
 {
-    size_t sz = 1;
-    for(int i=0; i<sizes_.size(); ++i) {
-        sz *= sizes_[i];
-    }
-    return sz;
+    execute_forward(sizes, batch, real, complex, std::vector<int>());
 }
 
-size_t FourierTransformFFTW::fourier_size() const
+void FourierTransformFFTW::inverse_fourier_batch(const std::vector<int>& sizes, size_t batch, const double* complex, double* real)
 {
-    size_t sz = sizes_[0]/2+1;
-    for(int i=1; i<sizes_.size(); ++i) {
-        sz *= sizes_[i];
-    }
-    return sz;
+    execute_inverse(sizes, batch, complex, real, std::vector<int>());
 }
 
-double FourierTransformFFTW::normalization_factor()
+void FourierTransformFFTW::forward_fourier_batch(const std::vector<int>& sizes, size_t batch, const double* real, double* complex, const std::vector<int>& origin)
 {
-    if(real_size() < 1) return 1;
-    else {
-        return 1.0/sqrt((double)real_size());
-    }
+    execute_forward(sizes, batch, real, complex, origin);
 }
 
-std::vector<double> FourierTransformFFTW::forward_fourier(const std::vector<int>& sizes, const std::vector<double>& input)
+void FourierTransformFFTW::inverse_fourier_batch(const std::vector<int>& sizes, size_t batch, const double* complex, double* real, const std::vector<int>& origin)
 {
-    //std::cout << "Forward transform\n";
-    //Re-plan if required
-    if(!_initialized || sizes_ != sizes)
-    {
-        sizes_ = sizes;
-        create_plans();
-    }
-    
-    #pragma omp parallel for
-    for(int id=0; id<real_size(); id++) _real_data[id] = input[id];
-    
-    //Execute the plan
-    fftw_execute(_plan_r2c);
-    
-    std::vector<double> output(fourier_size()*2, 0.0);
-    
-    //Normalize and assign
-    double factor = this->normalization_factor();
-    
-    #pragma omp parallel for
-    for(int id=0; id<fourier_size(); id++)
-    {
-        output[2*id] = ((fftw_complex*)_complex_data)[id][0] * factor;
-        output[2*id+1] = ((fftw_complex*)_complex_data)[id][1] * -1 * factor;
-    }
-    //std::cout << "Finished forward\n";
-    return output;
+    execute_inverse(sizes, batch, complex, real, origin);
 }
 
-std::vector<double> FourierTransformFFTW::inverse_fourier(const std::vector<int>& sizes, const std::vector<double>& input)
+void FourierTransformFFTW::forward_complex_fourier(const std::vector<int>& sizes, const double* input, double* output, const std::vector<int>& origin)
 {
-    //std::cout << "Inverse transform\n";
-    //Re-plan if required
-    if(!_initialized || sizes_ != sizes)
-    {
-        sizes_ = sizes;
-        create_plans();
-    }
-    
-    //Normalize
-    double factor = this->normalization_factor();
-    
-    #pragma omp parallel for
-    for(int id=0; id<fourier_size(); id++)
-    {
-        ((fftw_complex*)_complex_data)[id][0] = input[2*id] * factor;
-        ((fftw_complex*)_complex_data)[id][1] = input[2*id+1] * -1* factor;
-    };
+    execute_complex(sizes, Direction::FORWARD, input, output, origin);
+}
 
-    //Execute the plan
-    fftw_execute(_plan_c2r);
-    
-    std::vector<double> output(real_size());
-    
-    #pragma omp parallel for
-    for(int id=0; id<real_size(); id++) output[id] = _real_data[id];
-    //std::cout << "Finished inverse\n";
-    return output;
-}
\ No newline at end of file
+void FourierTransformFFTW::inverse_complex_fourier(const std::vector<int>& sizes, const double* input, double* output, const std::vector<int>& origin)
+{
+    execute_complex(sizes, Direction::INVERSE, input, output, origin);
+}
+
+#ifdef EM_USE_FFTWF
+void FourierTransformFFTW::forward_fourier(const std::vector<int>& sizes, const float* real, float* complex)
+{
+    execute_forward(sizes, 1, real, complex, std::vector<int>());
+}
+
+void FourierTransformFFTW::inverse_fourier(const std::vector<int>& sizes, const float* complex, float* real)
+{
+    execute_inverse(sizes, 1, complex, real, std::vector<int>());
+}
+
+void FourierTransformFFTW::forward_fourier_batch(const std::vector<int>& sizes, size_t batch, const float* real, float* complex)
+{
+    execute_forward(sizes, batch, real, complex, std::vector<int>());
+}
+
+void FourierTransformFFTW::inverse_fourier_batch(const std::vector<int>& sizes, size_t batch, const float* complex, float* real)
+{
+    execute_inverse(sizes, batch, complex, real, std::vector<int>());
+}
+
+void FourierTransformFFTW::forward_fourier_batch(const std::vector<int>& sizes, size_t batch, const float* real, float* complex, const std::vector<int>& origin)
+{
+    execute_forward(sizes, batch, real, complex, origin);
+}
+
+void FourierTransformFFTW::inverse_fourier_batch(const std::vector<int>& sizes, size_t batch, const float* complex, float* real, const std::vector<int>& origin)
+{
+    execute_inverse(sizes, batch, complex, real, origin);
+}
+void FourierTransformFFTW::forward_complex_fourier(const std::vector<int>& sizes, const float* input, float* output, const std::vector<int>& origin)
+{
+    execute_complex(sizes, Direction::FORWARD, input, output, origin);
+}
+
+void FourierTransformFFTW::inverse_complex_fourier(const std::vector<int>& sizes, const float* input, float* output, const std::vector<int>& origin)
+{
+    execute_complex(sizes, Direction::INVERSE, input, output, origin);
+}
+#endif
@@ -20,63 +20,48 @@
 #include <iostream>
 #include <math.h>
 #include <memory>
-#include <mutex>
 
 #include <fftw3.h>
 
 #include "fft_interface.hpp"
+#include "fftw_plan_cache.hpp"
 
 namespace em {
     
     namespace fft {
 
         /**
-         * A class used for FFTW3 wisdom and Fourier Transforms.
+         * A class used for Fourier Transforms with FFTW3.
          * Objective: Class which can provide methods for doing Fourier 
-         * transforms using FFTW3 lib. The useful functionality of wisdom 
-         * is used by recycling plans if possible.
-         * Semantics: Uses the same plan if the size of the input remains 
-         * same, otherwise generates a new plan using FFTW_ESTIMATE
-         * Use of same class is recommended if using same data size
+         * transforms using FFTW3 lib. 
+         * Semantics: The plans are taken from the process wide 
+         * FFTWPlanCache, hence a plan is measured only once for each size
+         * and the transformers are cheap to create. The transformer has no
+         * state besides its execution policy and can be used from 
+         * several threads at the same time. Float data is transformed 
+         * with the single precision library (fftwf) if emkit is built 
+         * with it (EM_USE_FFTWF).
          */
         class FourierTransformFFTW : public FFTInterface {
         public:
             /**
              * Default constructor
-             * Sets the size variables to 0
+             * @param policy: threads used by FFTW and planning rigor
              */
-            FourierTransformFFTW();
+            FourierTransformFFTW(const ExecutionPolicy& policy = ExecutionPolicy());
             
             /**
              * Constructor pre-creating plans with the given sizes
              * @param sizes
+             * @param policy: threads used by FFTW and planning rigor
              */
-            FourierTransformFFTW(const std::vector<int>& sizes);
-
-            /**
-             * Copy constructor
-             */
-            FourierTransformFFTW(const FourierTransformFFTW& copy);
-
-            /**
-             * Default destructor
-             */
-            ~FourierTransformFFTW();
-
-            /**
-             * Definition of operator =
-             */
-            FourierTransformFFTW& operator=(const FourierTransformFFTW& rhs);
-
-            /**
-             * Resets the instance with the other
-             */
-            void reset(const FourierTransformFFTW& other);
-
+            FourierTransformFFTW(const std::vector<int>& sizes, const ExecutionPolicy& policy = ExecutionPolicy());
+            
             /**
-             * Clears the data
+             * Creates the double precision plans of the sizes in the 
+             * FFTWPlanCache
              */
-            void clear();
+            void prepare(const std::vector<int>& sizes) override;
 
             /**
              * Method to implement the function to provide forward Fourier
@@ -84,7 +69,9 @@ namespace em {
              * 
              * Transform the input real data to complex data.
              * Internally uses FFTW r2c plans and executions for the
-             * conversion. 
+             * conversion. The plan is executed directly on the memory
+             * of the input and the output, which are then normalized
+             * and conjugated in place in parallel.
              * 
              * The input real data is with origin at the 
              * lower left corner. x is the fastest changing direction 
@@ -98,13 +85,11 @@ namespace em {
              *  Memory order: 0  1  2  3  4  5  6  7
              *  Frequencies : 0  1  2  3  4 -3 -2 -1
              * 
-             * @param nx: size of x-dimension
-             * @param ny: size of y-dimension
-             * @param nz: size of z-dimension
+             * @param sizes: sizes of the real data
              * @param[in] real input data
-             * @param[out] output complex data
+             * @param[out] complex output data
              */
-            std::vector<double> forward_fourier(const std::vector<int>& sizes, const std::vector<double>& input) override;
+            void forward_fourier(const std::vector<int>& sizes, const double* real, double* complex) override;
 
             /**
              * Method to implement the function to provide inverse Fourier
@@ -112,7 +97,10 @@ namespace em {
              * 
              * Transform the input real data to complex data.
              * Internally uses FFTW c2r plans and executions for the
-             * conversion. 
+             * conversion. As c2r transforms overwrite their input, the
+             * complex data is staged in a buffer with the normalization
+             * and the conjugation applied in the same pass, the plan then
+             * writes directly in the output.
              * 
              * The input complex data with x dimension trimmed to half 
              * (due to the symmetric nature of Fourier space). 
@@ -126,79 +114,127 @@ namespace em {
              * lower left corner. x is the fastest changing direction 
              * and z is the slowest changing direction.
              * 
-             * @param nx: size of x-dimension
-             * @param ny: size of y-dimension
-             * @param nz: size of z-dimension
-             * @param[in] input complex data
-             * @param[out] output real data
+             * @param sizes: sizes of the real data
+             * @param[in] complex input data
+             * @param[out] real output data
              */
-            std::vector<double> inverse_fourier(const std::vector<int>& sizes, const std::vector<double>& input) override;
-
-        private:
-
+            void inverse_fourier(const std::vector<int>& sizes, const double* complex, double* real) override;
+            
             /**
-             * Creates the plans.
+             * Forward transforms of a batch of arrays with FFTW plans of
+             * several transforms (plan_many). The batch is executed in 
+             * groups of arrays of about kBatchBytes, which bounds the 
+             * memory used for planning.
              */
-            void create_plans();
-
+            void forward_fourier_batch(const std::vector<int>& sizes, size_t batch, const double* real, double* complex) override;
+            
             /**
-             * Returns the normalization factor needed to scale the complex data
-             * @return normalization factor
+             * Inverse transforms of a batch of arrays with FFTW plans of
+             * several transforms (plan_many).
              */
-            double normalization_factor();
-
+            void inverse_fourier_batch(const std::vector<int>& sizes, size_t batch, const double* complex, double* real) override;
+            
             /**
-             * Returns the size of the fftw_complex for the corresponding size.
-             * The Fourier space is trimmed to half as is symmetric. So this
-             * function returns this size of the trimmed space
-             * @return Fourier size
+             * Forward transforms of a batch written in the centered layout.
+             * The normalization, the conjugation and the shift are applied
+             * in a single pass over the output of FFTW.
              */
-            size_t fourier_size() const;
-
-            size_t real_size() const;
-
-            std::vector<int> reversed_sizes() const;
-
-
-            /*===================
-             * Members
-             ====================*/
-
+            void forward_fourier_batch(const std::vector<int>& sizes, size_t batch, const double* real, double* complex, const std::vector<int>& origin) override;
+            
             /**
-             * Holds the plan for real to complex conversion
+             * Inverse transforms of a batch stored in the centered layout.
+             * The input is shifted back while it is staged for FFTW.
              */
-            fftw_plan _plan_r2c;
-
+            void inverse_fourier_batch(const std::vector<int>& sizes, size_t batch, const double* complex, double* real, const std::vector<int>& origin) override;
+            
             /**
-             * Holds the plan for complex to real conversion
+             * Complex to complex forward transform with the cached FFTW 
+             * plans (in place or out of place). The output is normalized 
+             * in place, or shifted to the origin with the normalization
+             * in a single pass.
              */
-            fftw_plan _plan_c2r;
-
+            void forward_complex_fourier(const std::vector<int>& sizes, const double* input, double* output, const std::vector<int>& origin) override;
+            
             /**
-             * Holds the size of the transform
+             * Complex to complex inverse transform with the cached FFTW
+             * plans. A centered input is shifted back while it is staged
+             * in the output, which is then transformed in place.
              */
-            std::vector<int> sizes_;
+            void inverse_complex_fourier(const std::vector<int>& sizes, const double* input, double* output, const std::vector<int>& origin) override;
 
+#ifdef EM_USE_FFTWF
             /**
-             * Holds the real space data allocated using fftw_malloc
+             * Single precision forward transform with the fftwf plans
              */
-            double* _real_data;
-
+            void forward_fourier(const std::vector<int>& sizes, const float* real, float* complex) override;
+            
             /**
-             * Holds the complex data allocated using fftw_malloc 
+             * Single precision inverse transform with the fftwf plans
              */
-            fftw_complex* _complex_data;
+            void inverse_fourier(const std::vector<int>& sizes, const float* complex, float* real) override;
+            
+            void forward_fourier_batch(const std::vector<int>& sizes, size_t batch, const float* real, float* complex) override;
+            
+            void inverse_fourier_batch(const std::vector<int>& sizes, size_t batch, const float* complex, float* real) override;
+            
+            void forward_fourier_batch(const std::vector<int>& sizes, size_t batch, const float* real, float* complex, const std::vector<int>& origin) override;
+            
+            void inverse_fourier_batch(const std::vector<int>& sizes, size_t batch, const float* complex, float* real, const std::vector<int>& origin) override;
+            
+            void forward_complex_fourier(const std::vector<int>& sizes, const float* input, float* output, const std::vector<int>& origin) override;
+            
+            void inverse_complex_fourier(const std::vector<int>& sizes, const float* input, float* output, const std::vector<int>& origin) override;
+#endif
+            
+            using FFTInterface::forward_fourier;
+            using FFTInterface::inverse_fourier;
+            using FFTInterface::forward_fourier_batch;
+            using FFTInterface::inverse_fourier_batch;
+            using FFTInterface::forward_complex_fourier;
+            using FFTInterface::inverse_complex_fourier;
+
+        private:
 
             /**
-             * Flag to check if the members are initialized
+             * Returns the normalization factor needed to scale the complex data
+             * of one transform
+             * @return normalization factor
              */
-            bool _initialized;
-
+            static double normalization_factor(const std::vector<int>& sizes);
+            
             /**
-             * Mutex to execute on single thread
+             * Number of arrays of the batch transformed by one plan
              */
-            static std::mutex mutex_;
-
+            template<typename Real_>
+            static size_t group_size(const std::vector<int>& sizes, size_t batch);
+            
+            /**
+             * Executes the cached forward plans of the precision of Real_
+             * on the batch and normalizes the output, shifted to the 
+             * origin if it is not zero
+             */
+            template<typename Real_>
+            void execute_forward(const std::vector<int>& sizes, size_t batch, const Real_* real, Real_* complex, const std::vector<int>& origin) const;
+            
+            /**
+             * Stages the normalized input shifted back from the origin and
+             * executes the cached inverse plans of the precision of Real_ 
+             * on the batch
+             */
+            template<typename Real_>
+            void execute_inverse(const std::vector<int>& sizes, size_t batch, const Real_* complex, Real_* real, const std::vector<int>& origin) const;
+            
+            /**
+             * Executes the cached complex to complex plan of the precision
+             * of Real_ and the direction, normalizing the output
+             */
+            template<typename Real_>
+            void execute_complex(const std::vector<int>& sizes, Direction direction, const Real_* input, Real_* output, const std::vector<int>& origin) const;
+            
+            /**
+             * Size of the arrays transformed by one batch plan
+             */
+            static const size_t kBatchBytes = 32 * 1024 * 1024;
 
         }; // class FourierTransformFFTW
 
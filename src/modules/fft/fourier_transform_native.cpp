@@ -0,0 +1,384 @@
+/* 
+ * Author: Nikhil Biyani - nikhil(dot)biyani(at)gmail(dot)com
+ *
+ * This file is a part of 2dx.
+ * 
+ * 2dx is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * 2dx is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include <complex>
+#include <algorithm>
+
+#include "fourier_transform_native.hpp"
+#include "../../parallel/parallel_algorithm.hpp"
+
+using namespace em::fft;
+
+namespace {
+    
+    /**
+     * Number of lines transformed together
+     */
+    const size_t kLanes = 16;
+    
+    /**
+     * Parallel copy of the memory
+     */
+    template<typename Value_>
+    void copy(const Value_* input, size_t size, Value_* output)
+    {
+        em::parallel::parallel_for(size, em::parallel::block_size<Value_>(), [&](size_t begin, size_t end) {
+            std::copy(input + begin, input + end, output + begin);
+        });
+    }
+    
+    /**
+     * exp(sign * 2 pi i k / size) for k in [0, count)
+     */
+    template<typename Real_>
+    std::vector<std::complex<Real_>> roots(size_t size, size_t count, int sign)
+    {
+        std::vector<std::complex<Real_>> values(count);
+        for(size_t k=0; k<count; k++)
+        {
+            const double angle = sign * 2.0 * M_PI * (double) k / (double) size;
+            values[k] = std::complex<Real_>((Real_) std::cos(angle), (Real_) std::sin(angle));
+        }
+        return values;
+    }
+    
+    /**
+     * Transforms in place all the lines of a column major array along a
+     * dimension and scales them. The lines are gathered kLanes at a time,
+     * consecutive lines being consecutive columns (or rows for x).
+     */
+    template<typename Real_>
+    void transform_lines(std::complex<Real_>* data, const std::vector<size_t>& range, size_t dim, int sign, Real_ scale)
+    {
+        using complex_type = std::complex<Real_>;
+        const size_t extent = range[dim];
+        if (extent <= 1 && scale == 1) return;
+        
+        size_t inner = 1, total = 1;
+        for(size_t d=0; d<range.size(); d++)
+        {
+            if (d < dim) inner *= range[d];
+            total *= range[d];
+        }
+        const size_t lines = total / extent;
+        const size_t groups = (lines + kLanes - 1) / kLanes;
+        auto plan = native_plan<Real_>(extent, sign);
+        
+        em::parallel::parallel_for(groups, std::max<size_t>(1, em::parallel::block_size<complex_type>() / (kLanes*extent)), [&](size_t begin, size_t end) {
+            std::vector<complex_type> buffer(extent*kLanes), work(plan->work_size(kLanes));
+            size_t starts[kLanes];
+            for(size_t group=begin; group<end; group++)
+            {
+                const size_t first = group*kLanes;
+                const size_t lanes = std::min(kLanes, lines - first);
+                for(size_t l=0; l<lanes; l++)
+                {
+                    const size_t line = first + l;
+                    starts[l] = (line / inner)*inner*extent + line % inner;
+                }
+                
+                for(size_t k=0; k<extent; k++)
+                {
+                    for(size_t l=0; l<lanes; l++) buffer[k*lanes + l] = data[starts[l] + k*inner];
+                }
+                plan->execute(buffer.data(), work.data(), lanes);
+                for(size_t k=0; k<extent; k++)
+                {
+                    for(size_t l=0; l<lanes; l++) data[starts[l] + k*inner] = buffer[k*lanes + l] * scale;
+                }
+            }
+        });
+    }
+    
+    /**
+     * Real to complex transforms of the rows (x) of the real array, 
+     * writing the length/2+1 first frequencies of every row. An even 
+     * length is transformed as a complex sequence of half the length 
+     * holding the even and the odd values, which are separated 
+     * afterwards.
+     */
+    template<typename Real_>
+    void forward_rows(const Real_* real, std::complex<Real_>* complex, size_t length, size_t rows, int sign, Real_ scale)
+    {
+        using complex_type = std::complex<Real_>;
+        const size_t half = length / 2 + 1;
+        const bool even = (length % 2 == 0);
+        const size_t extent = even ? length / 2 : length;
+        const size_t groups = (rows + kLanes - 1) / kLanes;
+        auto plan = native_plan<Real_>(extent, sign);
+        const std::vector<complex_type> twiddles = roots<Real_>(length, half, sign);
+        
+        em::parallel::parallel_for(groups, std::max<size_t>(1, em::parallel::block_size<complex_type>() / (kLanes*extent)), [&](size_t begin, size_t end) {
+            std::vector<complex_type> buffer(extent*kLanes), work(plan->work_size(kLanes));
+            for(size_t group=begin; group<end; group++)
+            {
+                const size_t first = group*kLanes;
+                const size_t lanes = std::min(kLanes, rows - first);
+                for(size_t l=0; l<lanes; l++)
+                {
+                    const Real_* row = real + (first + l)*length;
+                    if (even) for(size_t k=0; k<extent; k++) buffer[k*lanes + l] = complex_type(row[2*k], row[2*k + 1]);
+                    else for(size_t k=0; k<extent; k++) buffer[k*lanes + l] = complex_type(row[k], 0);
+                }
+                plan->execute(buffer.data(), work.data(), lanes);
+                
+                for(size_t l=0; l<lanes; l++)
+                {
+                    complex_type* row = complex + (first + l)*half;
+                    if (!even)
+                    {
+                        for(size_t k=0; k<half; k++) row[k] = buffer[k*lanes + l] * scale;
+                        continue;
+                    }
+                    for(size_t k=0; k<half; k++)
+                    {
+                        //Even (e) and odd (o) parts of the packed transform
+                        const complex_type z = buffer[(k % extent)*lanes + l];
+                        const complex_type mirror = std::conj(buffer[((extent - k % extent) % extent)*lanes + l]);
+                        const complex_type e = (z + mirror) * (Real_) 0.5;
+                        const complex_type d = (z - mirror) * (Real_) 0.5;
+                        const complex_type o(d.imag(), -d.real());
+                        row[k] = (e + native_impl::multiply(twiddles[k], o)) * scale;
+                    }
+                }
+            }
+        });
+    }
+    
+    /**
+     * Complex to real transforms of the rows (x) of length/2+1 
+     * frequencies, the other frequencies being given by the Friedel 
+     * symmetry. The imaginary parts of the frequencies without a Friedel
+     * mate in the row are ignored. An even length is transformed as a 
+     * complex sequence of half the length giving the even and the odd 
+     * values.
+     */
+    template<typename Real_>
+    void inverse_rows(const std::complex<Real_>* complex, Real_* real, size_t length, size_t rows, int sign, Real_ scale)
+    {
+        using complex_type = std::complex<Real_>;
+        const size_t half = length / 2 + 1;
+        const bool even = (length % 2 == 0);
+        const size_t extent = even ? length / 2 : length;
+        const size_t groups = (rows + kLanes - 1) / kLanes;
+        auto plan = native_plan<Real_>(extent, sign);
+        const std::vector<complex_type> twiddles = roots<Real_>(length, half, sign);
+        
+        em::parallel::parallel_for(groups, std::max<size_t>(1, em::parallel::block_size<complex_type>() / (kLanes*extent)), [&](size_t begin, size_t end) {
+            std::vector<complex_type> buffer(extent*kLanes), work(plan->work_size(kLanes));
+            for(size_t group=begin; group<end; group++)
+            {
+                const size_t first = group*kLanes;
+                const size_t lanes = std::min(kLanes, rows - first);
+                for(size_t l=0; l<lanes; l++)
+                {
+                    const complex_type* row = complex + (first + l)*half;
+                    if (!even)
+                    {
+                        buffer[l] = complex_type(row[0].real(), 0);
+                        for(size_t k=1; k<half; k++) buffer[k*lanes + l] = row[k];
+                        for(size_t k=half; k<length; k++) buffer[k*lanes + l] = std::conj(row[length - k]);
+                        continue;
+                    }
+                    for(size_t k=0; k<extent; k++)
+                    {
+                        //Frequencies k and k + length/2 combined in even and odd parts
+                        const complex_type low = (k == 0) ? complex_type(row[0].real(), 0) : row[k];
+                        const complex_type high = (k == 0) ? complex_type(row[extent].real(), 0) : std::conj(row[extent - k]);
+                        const complex_type odd = native_impl::multiply(low - high, twiddles[k]);
+                        buffer[k*lanes + l] = (low + high) + complex_type(-odd.imag(), odd.real());
+                    }
+                }
+                plan->execute(buffer.data(), work.data(), lanes);
+                
+                for(size_t l=0; l<lanes; l++)
+                {
+                    Real_* row = real + (first + l)*length;
+                    if (even)
+                    {
+                        for(size_t k=0; k<extent; k++)
+                        {
+                            row[2*k] = buffer[k*lanes + l].real() * scale;
+                            row[2*k + 1] = buffer[k*lanes + l].imag() * scale;
+                        }
+                    }
+                    else for(size_t k=0; k<extent; k++) row[k] = buffer[k*lanes + l].real() * scale;
+                }
+            }
+        });
+    }
+    
+    template<typename Real_>
+    Real_ normalization_factor(size_t size)
+    {
+        return size < 1 ? 1 : (Real_) (1.0/std::sqrt((double) size));
+    }
+    
+}
+
+FourierTransformNative::FourierTransformNative(const ExecutionPolicy& policy)
+: FFTInterface(policy)
+{
+}
+
+void FourierTransformNative::prepare(const std::vector<int>& sizes)
+{
+    for(size_t dim=0; dim<sizes.size(); dim++)
+    {
+        size_t extent = sizes[dim];
+        if (dim == 0 && extent % 2 == 0) extent /= 2;
+        native_plan<double>(extent, 1);
+        native_plan<double>(extent, -1);
+    }
+}
+
+template<typename Real_>
+void FourierTransformNative::execute_forward(const std::vector<int>& sizes, size_t batch, const Real_* real, Real_* complex) const
+{
+    if (sizes.empty() || real_size(sizes)*batch == 0) return;
+    
+    //The forward transform has the positive exponent, which gives the
+    //conjugate of the usual transform
+    const Real_ factor = normalization_factor<Real_>(real_size(sizes));
+    const std::vector<size_t> range = complex_range(sizes, batch);
+    std::complex<Real_>* output = as_complex(complex);
+    
+    forward_rows(real, output, sizes[0], real_size(sizes)/sizes[0]*batch, 1, sizes.size() == 1 ? factor : (Real_) 1);
+    for(size_t dim=1; dim<sizes.size(); dim++)
+    {
+        transform_lines(output, range, dim, 1, dim == sizes.size() - 1 ? factor : (Real_) 1);
+    }
+}
+
+template<typename Real_>
+void FourierTransformNative::execute_inverse(const std::vector<int>& sizes, size_t batch, const Real_* complex, Real_* real) const
+{
+    if (sizes.empty() || real_size(sizes)*batch == 0) return;
+    
+    const Real_ factor = normalization_factor<Real_>(real_size(sizes));
+    const std::vector<size_t> range = complex_range(sizes, batch);
+    const std::complex<Real_>* input = as_complex(complex);
+    
+    std::vector<std::complex<Real_>> staged;
+    if (sizes.size() > 1)
+    {
+        staged.resize(complex_size(sizes)*batch);
+        copy(input, staged.size(), staged.data());
+        for(size_t dim=sizes.size() - 1; dim>0; dim--) transform_lines(staged.data(), range, dim, -1, (Real_) 1);
+        input = staged.data();
+    }
+    inverse_rows(input, real, sizes[0], real_size(sizes)/sizes[0]*batch, -1, factor);
+}
+
+template<typename Real_>
+void FourierTransformNative::execute_complex(const std::vector<int>& sizes, int sign, const Real_* input, Real_* output, const std::vector<int>& origin) const
+{
+    const size_t size = real_size(sizes);
+    if (sizes.empty() || size == 0) return;
+    
+    const bool centered = !is_zero(origin);
+    assert(!(centered && input == output));
+    const Real_ factor = normalization_factor<Real_>(size);
+    const std::vector<size_t> range = full_range(sizes, 1);
+    auto normalize = [factor](const std::complex<Real_>& value) {
+        return value * factor;
+    };
+    auto transform = [&](std::complex<Real_>* data, Real_ scale) {
+        for(size_t dim=0; dim<sizes.size(); dim++) transform_lines(data, range, dim, sign, dim == sizes.size() - 1 ? scale : (Real_) 1);
+    };
+    
+    if (centered && sign < 0)
+    {
+        //The output stages the normalized input shifted back to the lower
+        //left corner, which is then transformed in place
+        shifted_copy(as_complex(input), as_complex(output), range, opposite(origin), normalize);
+        transform(as_complex(output), 1);
+    }
+    else if (centered)
+    {
+        std::vector<std::complex<Real_>> staged(as_complex(input), as_complex(input) + size);
+        transform(staged.data(), 1);
+        shifted_copy(staged.data(), as_complex(output), range, origin, normalize);
+    }
+    else
+    {
+        if (input != output) copy(input, size*2, output);
+        transform(as_complex(output), factor);
+    }
+}
+
+void FourierTransformNative::forward_fourier(const std::vector<int>& sizes, const double* real, double* complex)
+{
+    execute_forward(sizes, 1, real, complex);
+}
+
+void FourierTransformNative::inverse_fourier(const std::vector<int>& sizes, const double* complex, double* real)
+{
+    execute_inverse(sizes, 1, complex, real);
+}
+
+void FourierTransformNative::forward_fourier(const std::vector<int>& sizes, const float* real, float* complex)
+{
+    execute_forward(sizes, 1, real, complex);
+}
+
+void FourierTransformNative::inverse_fourier(const std::vector<int>& sizes, const float* complex, float* real)
+{
+    execute_inverse(sizes, 1, complex, real);
+}
+
+void FourierTransformNative::forward_fourier_batch(const std::vector<int>& sizes, size_t batch, const double* real, double* complex)
+{
+    execute_forward(sizes, batch, real, complex);
+}
+
+void FourierTransformNative::inverse_fourier_batch(const std::vector<int>& sizes, size_t batch, const double* complex, double* real)
+{
+    execute_inverse(sizes, batch, complex, real);
+}
+
+void FourierTransformNative::forward_fourier_batch(const std::vector<int>& sizes, size_t batch, const float* real, float* complex)
+{
+    execute_forward(sizes, batch, real, complex);
+}
+
+void FourierTransformNative::inverse_fourier_batch(const std::vector<int>& sizes, size_t batch, const float* complex, float* real)
+{
+    execute_inverse(sizes, batch, complex, real);
+}
+
+void FourierTransformNative::forward_complex_fourier(const std::vector<int>& sizes, const double* input, double* output, const std::vector<int>& origin)
+{
+    execute_complex(sizes, 1, input, output, origin);
+}
+
+void FourierTransformNative::inverse_complex_fourier(const std::vector<int>& sizes, const double* input, double* output, const std::vector<int>& origin)
+{
+    execute_complex(sizes, -1, input, output, origin);
+}
+
+void FourierTransformNative::forward_complex_fourier(const std::vector<int>& sizes, const float* input, float* output, const std::vector<int>& origin)
+{
+    execute_complex(sizes, 1, input, output, origin);
+}
+
+void FourierTransformNative::inverse_complex_fourier(const std::vector<int>& sizes, const float* input, float* output, const std::vector<int>& origin)
+{
+    execute_complex(sizes, -1, input, output, origin);
+}
@@ -0,0 +1,123 @@
+/* 
+ * Author: Nikhil Biyani - nikhil(dot)biyani(at)gmail(dot)com
+ *
+ * This file is a part of 2dx.
+ * 
+ * 2dx is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * 2dx is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FOURIER_TRANSFORM_NATIVE_HPP
+#define FOURIER_TRANSFORM_NATIVE_HPP
+
+#include <vector>
+
+#include "fft_interface.hpp"
+#include "native_fft_plan.hpp"
+
+namespace em {
+    
+    namespace fft {
+
+        /**
+         * A portable Fourier transform written in C++, used where FFTW is
+         * not available and as a reference for FFTW.
+         * 
+         * The one dimensional transforms are mixed radix Stockham 
+         * transforms (see NativeFFTPlan). The real transforms along x 
+         * are done with a complex transform of half the size when x is 
+         * even. The other dimensions are transformed in place, several 
+         * columns at a time so that the inner loops run over contiguous
+         * memory. The lines of a dimension are transformed in parallel on
+         * the parallel::ThreadPool.
+         * 
+         * The layout, the normalization and the conjugation of the data 
+         * are the ones of FFTInterface, hence the backends can be swapped.
+         * Float data is transformed in single precision.
+         */
+        class FourierTransformNative : public FFTInterface {
+        public:
+            
+            /**
+             * Default constructor
+             * @param policy: the planning rigor is not used
+             */
+            FourierTransformNative(const ExecutionPolicy& policy = ExecutionPolicy());
+            
+            /**
+             * Creates the one dimensional plans used by the transforms of 
+             * the sizes
+             */
+            void prepare(const std::vector<int>& sizes) override;
+            
+            void forward_fourier(const std::vector<int>& sizes, const double* real, double* complex) override;
+            
+            void inverse_fourier(const std::vector<int>& sizes, const double* complex, double* real) override;
+            
+            void forward_fourier(const std::vector<int>& sizes, const float* real, float* complex) override;
+            
+            void inverse_fourier(const std::vector<int>& sizes, const float* complex, float* real) override;
+            
+            /**
+             * Forward transforms of a batch. The rows of all the arrays 
+             * are transformed together, then the other dimensions.
+             */
+            void forward_fourier_batch(const std::vector<int>& sizes, size_t batch, const double* real, double* complex) override;
+            
+            void inverse_fourier_batch(const std::vector<int>& sizes, size_t batch, const double* complex, double* real) override;
+            
+            void forward_fourier_batch(const std::vector<int>& sizes, size_t batch, const float* real, float* complex) override;
+            
+            void inverse_fourier_batch(const std::vector<int>& sizes, size_t batch, const float* complex, float* real) override;
+            
+            void forward_complex_fourier(const std::vector<int>& sizes, const double* input, double* output, const std::vector<int>& origin) override;
+            
+            void inverse_complex_fourier(const std::vector<int>& sizes, const double* input, double* output, const std::vector<int>& origin) override;
+            
+            void forward_complex_fourier(const std::vector<int>& sizes, const float* input, float* output, const std::vector<int>& origin) override;
+            
+            void inverse_complex_fourier(const std::vector<int>& sizes, const float* input, float* output, const std::vector<int>& origin) override;
+            
+            using FFTInterface::forward_fourier;
+            using FFTInterface::inverse_fourier;
+            using FFTInterface::forward_fourier_batch;
+            using FFTInterface::inverse_fourier_batch;
+            
+        private:
+            
+            /**
+             * Real to complex transforms of the batch, normalized and 
+             * conjugated
+             */
+            template<typename Real_>
+            void execute_forward(const std::vector<int>& sizes, size_t batch, const Real_* real, Real_* complex) const;
+            
+            /**
+             * Complex to real transforms of the batch. The complex data is
+             * staged as its dimensions other than x are transformed in 
+             * place.
+             */
+            template<typename Real_>
+            void execute_inverse(const std::vector<int>& sizes, size_t batch, const Real_* complex, Real_* real) const;
+            
+            /**
+             * Normalized complex to complex transform with the given sign
+             * of the exponent, in place or out of place
+             */
+            template<typename Real_>
+            void execute_complex(const std::vector<int>& sizes, int sign, const Real_* input, Real_* output, const std::vector<int>& origin) const;
+            
+        }; // class FourierTransformNative
+        
+    }
+}
+
+#endif /* FOURIER_TRANSFORM_NATIVE_HPP */
+
@@ -0,0 +1,319 @@
+/* 
+ * Author: Nikhil Biyani - nikhil(dot)biyani(at)gmail(dot)com
+ *
+ * This file is a part of 2dx.
+ * 
+ * 2dx is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * 2dx is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NATIVE_FFT_PLAN_HPP
+#define NATIVE_FFT_PLAN_HPP
+
+#include <cstddef>
+#include <cmath>
+#include <vector>
+#include <complex>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <algorithm>
+
+namespace em {
+    
+    namespace fft {
+        
+        namespace native_impl {
+            
+            template<typename Real_>
+            inline std::complex<Real_> multiply(const std::complex<Real_>& a, const std::complex<Real_>& b) {
+                return std::complex<Real_>(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+            }
+            
+            /**
+             * Multiplication with sign*i
+             */
+            template<typename Real_>
+            inline std::complex<Real_> rotate(const std::complex<Real_>& a, Real_ sign) {
+                return std::complex<Real_>(-sign * a.imag(), sign * a.real());
+            }
+            
+        }
+        
+        /**
+         * @brief       A one dimensional complex transform of a size with 
+         *              the mixed radix Stockham algorithm
+         * @description The size is factored in radices 4, 2, 3, 5 which 
+         *              have dedicated butterflies, the remaining factors
+         *              (7 and larger primes) use a generic butterfly. Each
+         *              stage reads the input with a constant stride and
+         *              writes the output in order (autosort), hence no bit
+         *              reversal is needed. The twiddle factors of all the 
+         *              stages are precomputed.
+         * 
+         *              The plan transforms several sequences (lanes) at 
+         *              once, the element k of the lane l being stored at 
+         *              k*lanes + l. The innermost loops run over the lanes
+         *              and can be vectorized by the compiler, this is how 
+         *              the columns of the multidimensional transforms are 
+         *              processed.
+         * 
+         *              The transform is not normalized:
+         *              X[k] = sum_j x[j] exp(sign * 2 pi i j k / size)
+         */
+        template<typename Real_>
+        class NativeFFTPlan {
+        public:
+            using real_type = Real_;
+            using complex_type = std::complex<Real_>;
+            
+            NativeFFTPlan(size_t size, int sign)
+            : size_(size), sign_(sign), max_radix_(1) {
+                size_t remaining = size;
+                size_t stride = 1;
+                while (remaining > 1) {
+                    const size_t radix = next_radix(remaining);
+                    add_stage(radix, stride);
+                    max_radix_ = std::max(max_radix_, radix);
+                    remaining /= radix;
+                    stride *= radix;
+                }
+            }
+            
+            size_t size() const {
+                return size_;
+            }
+            
+            int sign() const {
+                return sign_;
+            }
+            
+            /**
+             * Number of values of the scratch needed by execute() for the
+             * given number of lanes: a copy of the data and the values of
+             * one butterfly before and after its transform.
+             */
+            size_t work_size(size_t lanes) const {
+                return (size_ + 2 * max_radix_) * lanes;
+            }
+            
+            /**
+             * Transforms the lanes of the data in place
+             * @param data: size*lanes values
+             * @param work: work_size(lanes) values used as scratch
+             * @param lanes
+             */
+            void execute(complex_type* data, complex_type* work, size_t lanes) const {
+                complex_type* input = data;
+                complex_type* output = work;
+                complex_type* values = work + size_ * lanes;
+                for (const Stage& stage : stages_) {
+                    execute_stage(stage, input, output, values, lanes);
+                    std::swap(input, output);
+                }
+                if (input != data) std::copy(input, input + size_ * lanes, data);
+            }
+            
+        private:
+            
+            struct Stage {
+                size_t radix;
+                size_t stride;
+                size_t twiddles;
+                size_t roots;
+            };
+            
+            /**
+             * Largest preferred radix dividing the size. A single radix 2
+             * is left for an odd power of 2.
+             */
+            static size_t next_radix(size_t size) {
+                if (size % 4 == 0 && size != 8) return 4;
+                for (size_t radix : {2, 3, 5, 7}) {
+                    if (size % radix == 0) return radix;
+                }
+                for (size_t radix = 11; radix * radix <= size; radix += 2) {
+                    if (size % radix == 0) return radix;
+                }
+                return size;
+            }
+            
+            complex_type root(size_t numerator, size_t denominator) const {
+                const double angle = sign_ * 2.0 * M_PI * (double) (numerator % denominator) / (double) denominator;
+                return complex_type((Real_) std::cos(angle), (Real_) std::sin(angle));
+            }
+            
+            /**
+             * Adds a stage of the given radix after the stages of the 
+             * radices with the given product (stride)
+             */
+            void add_stage(size_t radix, size_t stride) {
+                Stage stage = {radix, stride, twiddles_.size(), roots_.size()};
+                for (size_t q = 0; q < stride; ++q) {
+                    for (size_t r = 1; r < radix; ++r) twiddles_.push_back(root(q * r, stride * radix));
+                }
+                if (radix > 5) {
+                    for (size_t r = 0; r < radix; ++r) roots_.push_back(root(r, radix));
+                }
+                stages_.push_back(stage);
+            }
+            
+            /**
+             * The butterflies of a stage. The butterfly j reads the 
+             * elements j + r*size/radix, applies the twiddles of its 
+             * position in the previous stages and writes its transform 
+             * with the stride of the previous stages. The values of a 
+             * butterfly are held in 2*radix*lanes values of scratch.
+             */
+            void execute_stage(const Stage& stage, const complex_type* input, complex_type* output,
+                    complex_type* values, size_t lanes) const {
+                const size_t radix = stage.radix;
+                const size_t butterflies = size_ / radix;
+                const Real_ sign = (Real_) sign_;
+                complex_type* results = values + radix * lanes;
+                
+                for (size_t j = 0; j < butterflies; ++j) {
+                    const size_t q = j % stage.stride;
+                    const size_t target = (j - q) * radix + q;
+                    const complex_type* twiddle = twiddles_.data() + stage.twiddles + q * (radix - 1);
+                    
+                    //Load and twiddle
+                    for (size_t r = 0; r < radix; ++r) {
+                        const complex_type* source = input + (j + r * butterflies) * lanes;
+                        complex_type* value = values + r * lanes;
+                        if (r == 0 || q == 0) std::copy(source, source + lanes, value);
+                        else for (size_t l = 0; l < lanes; ++l) value[l] = native_impl::multiply(source[l], twiddle[r - 1]);
+                    }
+                    
+                    complex_type* v = values;
+                    switch (radix) {
+                        case 2: butterfly2(v, lanes); break;
+                        case 3: butterfly3(v, lanes, sign); break;
+                        case 4: butterfly4(v, lanes, sign); break;
+                        case 5: butterfly5(v, lanes, sign); break;
+                        default: 
+                            butterfly(v, results, radix, roots_.data() + stage.roots, lanes);
+                            v = results;
+                    }
+                    
+                    for (size_t r = 0; r < radix; ++r) {
+                        std::copy(v + r * lanes, v + (r + 1) * lanes, output + (target + r * stage.stride) * lanes);
+                    }
+                }
+            }
+            
+            static void butterfly2(complex_type* v, size_t lanes) {
+                complex_type* v1 = v + lanes;
+                for (size_t l = 0; l < lanes; ++l) {
+                    const complex_type a = v[l], b = v1[l];
+                    v[l] = a + b;
+                    v1[l] = a - b;
+                }
+            }
+            
+            static void butterfly3(complex_type* v, size_t lanes, Real_ sign) {
+                const Real_ s = (Real_) (0.5 * std::sqrt(3.0));
+                complex_type* v1 = v + lanes;
+                complex_type* v2 = v + 2 * lanes;
+                for (size_t l = 0; l < lanes; ++l) {
+                    const complex_type t1 = v1[l] + v2[l];
+                    const complex_type t2 = native_impl::rotate(v1[l] - v2[l], sign) * s;
+                    const complex_type m = v[l] - t1 * (Real_) 0.5;
+                    v[l] = v[l] + t1;
+                    v1[l] = m + t2;
+                    v2[l] = m - t2;
+                }
+            }
+            
+            static void butterfly4(complex_type* v, size_t lanes, Real_ sign) {
+                complex_type* v1 = v + lanes;
+                complex_type* v2 = v + 2 * lanes;
+                complex_type* v3 = v + 3 * lanes;
+                for (size_t l = 0; l < lanes; ++l) {
+                    const complex_type t0 = v[l] + v2[l];
+                    const complex_type t1 = v[l] - v2[l];
+                    const complex_type t2 = v1[l] + v3[l];
+                    const complex_type t3 = native_impl::rotate(v1[l] - v3[l], sign);
+                    v[l] = t0 + t2;
+                    v1[l] = t1 + t3;
+                    v2[l] = t0 - t2;
+                    v3[l] = t1 - t3;
+                }
+            }
+            
+            static void butterfly5(complex_type* v, size_t lanes, Real_ sign) {
+                const Real_ c1 = (Real_) std::cos(2.0 * M_PI / 5.0);
+                const Real_ c2 = (Real_) std::cos(4.0 * M_PI / 5.0);
+                const Real_ s1 = (Real_) std::sin(2.0 * M_PI / 5.0);
+                const Real_ s2 = (Real_) std::sin(4.0 * M_PI / 5.0);
+                complex_type* v1 = v + lanes;
+                complex_type* v2 = v + 2 * lanes;
+                complex_type* v3 = v + 3 * lanes;
+                complex_type* v4 = v + 4 * lanes;
+                for (size_t l = 0; l < lanes; ++l) {
+                    const complex_type t1 = v1[l] + v4[l];
+                    const complex_type t2 = v2[l] + v3[l];
+                    const complex_type t3 = v1[l] - v4[l];
+                    const complex_type t4 = v2[l] - v3[l];
+                    const complex_type a1 = v[l] + t1 * c1 + t2 * c2;
+                    const complex_type a2 = v[l] + t1 * c2 + t2 * c1;
+                    const complex_type b1 = native_impl::rotate(t3 * s1 + t4 * s2, sign);
+                    const complex_type b2 = native_impl::rotate(t3 * s2 - t4 * s1, sign);
+                    v[l] = v[l] + t1 + t2;
+                    v1[l] = a1 + b1;
+                    v4[l] = a1 - b1;
+                    v2[l] = a2 + b2;
+                    v3[l] = a2 - b2;
+                }
+            }
+            
+            /**
+             * Direct transform of the values of a radix without dedicated
+             * butterfly
+             */
+            static void butterfly(const complex_type* v, complex_type* results, size_t radix, const complex_type* roots, size_t lanes) {
+                for (size_t k = 0; k < radix; ++k) {
+                    complex_type* result = results + k * lanes;
+                    std::copy(v, v + lanes, result);
+                    for (size_t r = 1; r < radix; ++r) {
+                        const complex_type w = roots[(r * k) % radix];
+                        const complex_type* value = v + r * lanes;
+                        for (size_t l = 0; l < lanes; ++l) result[l] += native_impl::multiply(value[l], w);
+                    }
+                }
+            }
+            
+            size_t size_;
+            int sign_;
+            size_t max_radix_;
+            std::vector<Stage> stages_;
+            std::vector<complex_type> twiddles_;
+            std::vector<complex_type> roots_;
+        };
+        
+        /**
+         * The process wide plan of a size and a sign, created on the first
+         * request. The plans are immutable and can be shared by threads.
+         */
+        template<typename Real_>
+        std::shared_ptr<const NativeFFTPlan<Real_>> native_plan(size_t size, int sign) {
+            static std::map<std::pair<size_t, int>, std::shared_ptr<const NativeFFTPlan<Real_>>> plans;
+            static std::mutex mutex;
+            std::lock_guard<std::mutex> lock(mutex);
+            auto& plan = plans[std::make_pair(size, sign)];
+            if (!plan) plan.reset(new NativeFFTPlan<Real_>(size, sign));
+            return plan;
+        }
+    }
+}
+
+#endif /* NATIVE_FFT_PLAN_HPP */
+
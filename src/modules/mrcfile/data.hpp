@@ -20,6 +20,7 @@
 #define MRC_DATA_HPP_PQVG38
 
 #include <vector>
+#include <memory>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -109,22 +110,25 @@ namespace em {
              *                  using the size of byte for each data point indicated
              *                  in the constructor and then converted to the
              *                  requested type
+             *                  type. The vector can use any allocator, so that it
+             *                  can be moved directly into a container.
              * @return          vector of the stored data
              */
-            template<typename value_type>
-            std::vector<value_type> get() const {
+            template<typename value_type, typename Allocator_ = std::allocator<value_type>>
+            std::vector<value_type, Allocator_> get() const {
                 size_t _points = data_points();
                 if (byte_size() == 1) {
                     const int8_t* data = reinterpret_cast<const int8_t*> (data_.data());
-                    return std::vector<value_type>(data, data + _points*block_size());
+                    return std::vector<value_type, Allocator_>(data, data + _points*block_size());
                 } else if (byte_size() == 2) {
                     const int16_t* data = reinterpret_cast<const int16_t*> (data_.data());
-                    return std::vector<value_type>(data, data + _points*block_size());
+                    return std::vector<value_type, Allocator_>(data, data + _points*block_size());
                 } else if (byte_size() == 4) {
                     const float* data = reinterpret_cast<const float*> (data_.data());
-                    return std::vector<value_type>(data, data + _points*block_size());
+                    return std::vector<value_type, Allocator_>(data, data + _points*block_size());
                 } else {
                     std::cerr << "Unidentified byte size " << byte_size() << " encountered. Possible (1, 2, 4)\n";
+                    return std::vector<value_type, Allocator_>();
                 }
             }
 
@@ -135,8 +139,8 @@ namespace em {
              *                  and then finally stored as a char vector
              * @param       data    vector of the data
              */
-            template<typename value_type>
-            void set(const std::vector<value_type>& data, int mode) {
+            template<typename value_type, typename Allocator_>
+            void set(const std::vector<value_type, Allocator_>& data, int mode) {
                 mode_ = mode;
                 data_.clear();
                 size_t _points = data.size()/block_size();
@@ -124,7 +124,7 @@ namespace em {
                 }
             };
 
-            bool exists(std::string field) {
+            bool exists(std::string field) const {
                 const auto& found_field = std::find(values_.begin(), values_.end(), field);
                 if (found_field == values_.end()) return false;
                 else return true;
@@ -62,6 +62,27 @@ namespace em {
                 }
             }
 
+            /**
+             * Loads only the header, e.g. to map the data from the file
+             * instead of reading it.
+             */
+            void load_header() {
+                std::ifstream is(file_name_, std::ios::binary);
+                if (!is.is_open()) {
+                    throw std::runtime_error("Unable to open file: '" + file_name_ + "' Are you sure the file exists?\n");
+                }
+                if (!header_.load(is)) {
+                    throw std::runtime_error("Unable to load header from file: " + file_name_);
+                }
+            }
+
+            /**
+             * Position of the data in the file in bytes
+             */
+            size_t data_offset() const {
+                return format_->data_offset();
+            }
+
             void save() {
                 if (header_.data_points() != data_.data_points()) {
                     throw std::runtime_error("The data points to be written in header and the actual present do not match");
@@ -19,6 +19,8 @@
 #ifndef EM_COMPLEX_HALF_OBJECT_HPP
 #define EM_COMPLEX_HALF_OBJECT_HPP
 
+#include <cassert>
+
 #include "../elements/complex.hpp"
 #include "../elements/tensor.hpp"
 #include "../elements/tensor_iterator.hpp"
@@ -49,29 +51,57 @@ namespace em {
              * @param range
              */
             ComplexHalfObject(const index_type& range)
-            : BaseType_(range), cell_lengths_(range) {
-                index_type complex_container_range = range;
-                complex_container_range[0] = complex_container_range[0] / 2 + 1;
-                BaseType_::resize(complex_container_range);
-                even_size_x_ = false;
-                if (range[0] % 2 == 0) even_size_x_ = true;
+            : BaseType_(half_range(range)), even_size_x_(range[0] % 2 == 0), cell_lengths_(range) {
             };
 
             ComplexHalfObject(const index_type& range, const index_type& origin)
-            : BaseType_(range, origin), cell_lengths_(range) {
-                index_type complex_container_range = range;
-                complex_container_range[0] = complex_container_range[0] / 2 + 1;
-                BaseType_::resize(complex_container_range);
-                even_size_x_ = false;
-                if (range[0] % 2 == 0) even_size_x_ = true;
+            : BaseType_(half_range(range), origin), even_size_x_(range[0] % 2 == 0), cell_lengths_(range) {
             };
 
             ComplexHalfObject(const BaseType_& tensor, bool is_first_dim_even = false)
-            : BaseType_(tensor), even_size_x_(is_first_dim_even), cell_lengths_(tensor.range()) {
+            : BaseType_(tensor), even_size_x_(is_first_dim_even), cell_lengths_(full_range(tensor.range(), is_first_dim_even)) {
+            };
+
+            /**
+             * Constructor taking over the memory of the tensor
+             */
+            ComplexHalfObject(BaseType_&& tensor, bool is_first_dim_even = false)
+            : BaseType_(std::move(tensor)), even_size_x_(is_first_dim_even), cell_lengths_(full_range(BaseType_::range(), is_first_dim_even)) {
+            };
+
+            /**
+             * Constructor evaluating an expression of complex half objects,
+             * e.g. a*w1 + b*w2. The stored range does not tell if the 
+             * logical x size is even, it has to be given and should be the
+             * one of the complex half objects in the expression.
+             */
+            template<typename Expression_>
+            explicit ComplexHalfObject(const element::TensorExpression<Expression_>& expr, bool is_first_dim_even)
+            : BaseType_(expr), even_size_x_(is_first_dim_even), cell_lengths_(full_range(expr.self().range(), is_first_dim_even)) {
+                assert(operands_have_parity(expr, is_first_dim_even));
             };
 
             ComplexHalfObject(const ComplexHalfObject& other) = default;
 
+            ComplexHalfObject(ComplexHalfObject&& other) = default;
+
+            ComplexHalfObject& operator=(const ComplexHalfObject& other) = default;
+
+            ComplexHalfObject& operator=(ComplexHalfObject&& other) = default;
+
+            /**
+             * Creates an object sharing the memory with this object, which
+             * is copied on the first write (see Tensor::share).
+             */
+            ComplexHalfObject share() const {
+                return ComplexHalfObject(BaseType_::share(), even_size_x_);
+            }
+
+            /**
+             * Evaluates an expression of the same range in place
+             */
+            using BaseType_::operator=;
+
             /**
              * Accessing elements
              */
@@ -131,18 +161,65 @@ namespace em {
             }
 
             index_type logical_range() const {
-                index_type rnge = BaseType_::range();
-                if (even_size_x_) rnge[0] = (rnge[0] - 1)*2;
-                else rnge[0] = rnge[0]*2 - 1;
-                return rnge;
+                return full_range(BaseType_::range(), even_size_x_);
             }
             
-            index_type cell_lengths() {
+            index_type cell_lengths() const {
                 return cell_lengths_;
             }
 
 
         private:
+            
+            /**
+             * Range of the stored half of the complex space for the logical
+             * range of the real space
+             */
+            static index_type half_range(index_type range) {
+                range[0] = range[0] / 2 + 1;
+                return range;
+            }
+            
+            /**
+             * Logical range of the real space for the range of the stored 
+             * half of the complex space
+             */
+            static index_type full_range(index_type range, bool is_first_dim_even) {
+                if (is_first_dim_even) range[0] = (range[0] - 1)*2;
+                else range[0] = range[0]*2 - 1;
+                return range;
+            }
+            
+            /**
+             * Checks the parity of the x size of the complex half objects
+             * among the terminals of an expression
+             */
+            struct ParityCheck {
+                bool is_first_dim_even;
+                bool matches;
+
+                template<typename Terminal_>
+                void operator()(const Terminal_& terminal) {
+                    check(terminal.source());
+                }
+
+                void check(const BaseType_* source) {
+                    const ComplexHalfObject* half = dynamic_cast<const ComplexHalfObject*> (source);
+                    if (half != nullptr && half->even_size_x_ != is_first_dim_even) matches = false;
+                }
+
+                template<typename OtherTensor_>
+                void check(const OtherTensor_*) {
+                }
+            };
+
+            template<typename Expression_>
+            static bool operands_have_parity(const element::TensorExpression<Expression_>& expr, bool is_first_dim_even) {
+                ParityCheck check = {is_first_dim_even, true};
+                element::expression::make_node(expr).visit_terminals(check);
+                return check.matches;
+            }
+            
             bool even_size_x_;
             index_type cell_lengths_;
         };
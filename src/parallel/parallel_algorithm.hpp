@@ -0,0 +1,181 @@
+/* 
+ * This file is a part of emkit.
+ * 
+ * emkit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * emkit is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>
+ * 
+ * Author:
+ * Nikhil Biyani: nikhil(dot)biyani(at)gmail(dot)com
+ * 
+ */
+
+#ifndef EM_PARALLEL_ALGORITHM_HPP
+#define EM_PARALLEL_ALGORITHM_HPP
+
+#include <cstddef>
+#include <cassert>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+
+#include "thread_pool.hpp"
+
+namespace em {
+
+    namespace parallel {
+
+        /**
+         * Number of bytes processed by a task. The linear storage of the
+         * tensors is split in blocks of this size, which fit in the L2 cache
+         * of a core and are small enough to balance the load of the threads.
+         */
+        static const size_t kBlockBytes = 256 * 1024;
+
+        /**
+         * Number of elements of the given type in a block
+         */
+        template<typename ValueType_>
+        size_t block_size() {
+            return std::max<size_t>(1, kBlockBytes / sizeof (ValueType_));
+        }
+
+        /**
+         * Calls function(begin, end) on the consecutive blocks of [0, size)
+         * in parallel. Each block has block_size elements (the last one can
+         * be shorter).
+         */
+        template<typename Function_>
+        void parallel_for(size_t size, size_t block_size, const Function_& function) {
+            assert(block_size > 0);
+            size_t num_blocks = (size + block_size - 1) / block_size;
+            if (num_blocks <= 1) {
+                if (size > 0) function(size_t(0), size);
+                return;
+            }
+            ThreadPool::Instance().run(num_blocks, [&](size_t block) {
+                size_t begin = block * block_size;
+                function(begin, std::min(begin + block_size, size));
+            });
+        }
+
+        /**
+         * Reduces the blocks of [0, size) in parallel. Each block is reduced
+         * with block_function(begin, end) and the results of the blocks are
+         * combined in the order of the blocks, so that the result does not
+         * depend on the scheduling of the threads.
+         */
+        template<typename ResultType_, typename BlockFunction_, typename Combine_>
+        ResultType_ parallel_reduce_blocks(size_t size, size_t block_size, const ResultType_& identity,
+                const BlockFunction_& block_function, const Combine_& combine) {
+            assert(block_size > 0);
+            size_t num_blocks = (size + block_size - 1) / block_size;
+            std::vector<ResultType_> partials(num_blocks, identity);
+            parallel_for(size, block_size, [&](size_t begin, size_t end) {
+                partials[begin / block_size] = block_function(begin, end);
+            });
+            ResultType_ result = identity;
+            for (const auto& partial : partials) result = combine(result, partial);
+            return result;
+        }
+
+        /**
+         * Applies function(value) on all the values of the container.
+         * The container (Tensor, RealObject, ComplexHalfObject) is traversed
+         * in its linear storage.
+         */
+        template<typename ContainerType_, typename Function_>
+        void parallel_for_each(ContainerType_& container, const Function_& function) {
+            using data_type = typename ContainerType_::data_type;
+            auto data = container.data();
+            parallel_for(container.size(), block_size<data_type>(), [&](size_t begin, size_t end) {
+                for (size_t id = begin; id < end; ++id) function(data[id]);
+            });
+        }
+
+        /**
+         * Applies function(pair) on all the elements of the range given by
+         * the random access iterators. The pair provides the index and the
+         * value of the element as in the range based for loops on the
+         * containers.
+         */
+        template<typename Iterator_, typename Function_>
+        void parallel_for_each(Iterator_ first, Iterator_ last, const Function_& function) {
+            using pair_type = typename std::iterator_traits<Iterator_>::value_type;
+            using data_type = typename std::remove_const<typename pair_type::value_type>::type;
+            parallel_for(std::distance(first, last), block_size<data_type>(), [&](size_t begin, size_t end) {
+                auto itr = first + begin;
+                for (size_t id = begin; id < end; ++id, ++itr) function(*itr);
+            });
+        }
+
+        /**
+         * Stores function(value) of all the values of input in the output
+         * of the same size.
+         */
+        template<typename InputType_, typename OutputType_, typename Function_>
+        void parallel_transform(const InputType_& input, OutputType_& output, const Function_& function) {
+            assert(input.size() == output.size());
+            using data_type = typename OutputType_::data_type;
+            auto in = input.data();
+            auto out = output.data();
+            parallel_for(input.size(), block_size<data_type>(), [&](size_t begin, size_t end) {
+                for (size_t id = begin; id < end; ++id) out[id] = function(in[id]);
+            });
+        }
+
+        /**
+         * Stores function(value1, value2) of all the values of input1 and
+         * input2 in the output of the same size.
+         */
+        template<typename InputType1_, typename InputType2_, typename OutputType_, typename Function_>
+        void parallel_transform(const InputType1_& input1, const InputType2_& input2, OutputType_& output, const Function_& function) {
+            assert(input1.size() == output.size() && input2.size() == output.size());
+            using data_type = typename OutputType_::data_type;
+            auto in1 = input1.data();
+            auto in2 = input2.data();
+            auto out = output.data();
+            parallel_for(output.size(), block_size<data_type>(), [&](size_t begin, size_t end) {
+                for (size_t id = begin; id < end; ++id) out[id] = function(in1[id], in2[id]);
+            });
+        }
+
+        /**
+         * Reduces all the values of the container. Each block starts from
+         * the identity and accumulates its values with
+         * accumulate(result, value), the results of the blocks are then
+         * combined with combine(result1, result2).
+         */
+        template<typename ContainerType_, typename ResultType_, typename Accumulate_, typename Combine_>
+        ResultType_ parallel_reduce(const ContainerType_& container, const ResultType_& identity,
+                const Accumulate_& accumulate, const Combine_& combine) {
+            using data_type = typename ContainerType_::data_type;
+            auto data = container.data();
+            return parallel_reduce_blocks(container.size(), block_size<data_type>(), identity, [&](size_t begin, size_t end) {
+                ResultType_ result = identity;
+                for (size_t id = begin; id < end; ++id) result = accumulate(result, data[id]);
+                return result;
+            }, combine);
+        }
+
+        /**
+         * Reduces all the values of the container with a single operation
+         * (e.g. std::plus) used for accumulation and combination.
+         */
+        template<typename ContainerType_, typename ResultType_, typename Operation_>
+        ResultType_ parallel_reduce(const ContainerType_& container, const ResultType_& identity, const Operation_& operation) {
+            return parallel_reduce(container, identity, operation, operation);
+        }
+
+    }
+}
+
+#endif /* EM_PARALLEL_ALGORITHM_HPP */
+
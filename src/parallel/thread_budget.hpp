@@ -0,0 +1,134 @@
+/* 
+ * This file is a part of emkit.
+ * 
+ * emkit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * emkit is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>
+ * 
+ * Author:
+ * Nikhil Biyani: nikhil(dot)biyani(at)gmail(dot)com
+ * 
+ */
+
+#ifndef EM_PARALLEL_THREAD_BUDGET_HPP
+#define EM_PARALLEL_THREAD_BUDGET_HPP
+
+#include <cstddef>
+#include <cstdlib>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+namespace em {
+
+    namespace parallel {
+
+        /**
+         * @brief       The number of threads the process should use
+         * @description The budget is shared by the application level 
+         *              parallelism (e.g. threads processing the images of a
+         *              stack) and the parallelism of the libraries (e.g. the
+         *              threads of FFTW). The application declares the number
+         *              of jobs it runs concurrently, every job then gets an
+         *              equal share of the budget, so that the machine is not
+         *              oversubscribed.
+         */
+        class ThreadBudget {
+        public:
+
+            /**
+             * The budget has all the hardware threads unless the number of
+             * threads is given with the environment variable
+             * EMKIT_NUM_THREADS.
+             */
+            static ThreadBudget& Instance() {
+                static ThreadBudget instance;
+                return instance;
+            }
+
+            ThreadBudget(const ThreadBudget&) = delete;
+
+            ThreadBudget& operator=(const ThreadBudget&) = delete;
+
+            static size_t default_threads() {
+                const char* env = std::getenv("EMKIT_NUM_THREADS");
+                if (env != nullptr && std::atoi(env) > 0) return std::atoi(env);
+                size_t hardware_threads = std::thread::hardware_concurrency();
+                return hardware_threads > 0 ? hardware_threads : 1;
+            }
+
+            /**
+             * Total number of threads of the process
+             */
+            size_t threads() const {
+                return threads_;
+            }
+
+            void set_threads(size_t threads) {
+                threads_ = std::max<size_t>(1, threads);
+            }
+
+            /**
+             * Number of jobs running concurrently
+             */
+            size_t concurrency() const {
+                return concurrency_;
+            }
+
+            void set_concurrency(size_t jobs) {
+                concurrency_ = std::max<size_t>(1, jobs);
+            }
+
+            /**
+             * Number of threads a job can use
+             */
+            size_t threads_per_job() const {
+                return std::max<size_t>(1, threads_ / concurrency_);
+            }
+
+        private:
+
+            ThreadBudget()
+            : threads_(default_threads()), concurrency_(1) {
+            }
+
+            std::atomic<size_t> threads_;
+            std::atomic<size_t> concurrency_;
+        };
+
+        /**
+         * Declares the number of jobs running concurrently in the scope,
+         * e.g. the threads of the application, and restores the previous
+         * concurrency when leaving it.
+         */
+        class ConcurrencyScope {
+        public:
+
+            explicit ConcurrencyScope(size_t jobs)
+            : previous_(ThreadBudget::Instance().concurrency()) {
+                ThreadBudget::Instance().set_concurrency(jobs);
+            }
+
+            ~ConcurrencyScope() {
+                ThreadBudget::Instance().set_concurrency(previous_);
+            }
+
+            ConcurrencyScope(const ConcurrencyScope&) = delete;
+
+            ConcurrencyScope& operator=(const ConcurrencyScope&) = delete;
+
+        private:
+            size_t previous_;
+        };
+
+    }
+}
+
+#endif /* EM_PARALLEL_THREAD_BUDGET_HPP */
+
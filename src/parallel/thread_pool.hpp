@@ -0,0 +1,195 @@
+/* 
+ * This file is a part of emkit.
+ * 
+ * emkit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or any 
+ * later version.
+ * 
+ * emkit is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public 
+ * License for more details <http://www.gnu.org/licenses/>
+ * 
+ * Author:
+ * Nikhil Biyani: nikhil(dot)biyani(at)gmail(dot)com
+ * 
+ */
+
+#ifndef EM_PARALLEL_THREAD_POOL_HPP
+#define EM_PARALLEL_THREAD_POOL_HPP
+
+#include <cstddef>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+
+#include "thread_budget.hpp"
+
+namespace em {
+
+    namespace parallel {
+
+        /**
+         * @brief       A persistent pool of worker threads
+         * @description The workers are created once and sleep until a job
+         *              is submitted with run(). A job is a number of tasks
+         *              identified by their ids, the tasks are picked up
+         *              dynamically by the workers and by the calling thread
+         *              which participates in the execution.
+         *
+         *              Only one job runs on the pool at a time. A job
+         *              submitted while the pool is busy (e.g. from inside a
+         *              task or from another thread) is executed serially on
+         *              the calling thread, so that nesting can not deadlock.
+         */
+        class ThreadPool {
+        public:
+
+            using task_type = std::function<void(size_t)>;
+
+            /**
+             * The pool uses all the hardware threads unless the number of
+             * threads is given with the environment variable
+             * EMKIT_NUM_THREADS.
+             */
+            static ThreadPool& Instance() {
+                static ThreadPool instance(default_num_threads());
+                return instance;
+            };
+
+            ~ThreadPool() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    stop_ = true;
+                }
+                wake_.notify_all();
+                for (auto& worker : workers_) worker.join();
+            }
+
+            ThreadPool(const ThreadPool&) = delete;
+
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            /**
+             * Number of threads executing a job including the caller
+             */
+            size_t size() const {
+                return workers_.size() + 1;
+            }
+
+            /**
+             * Executes task(id) for all the ids in [0, num_tasks) and
+             * returns once all of them are finished. The first exception
+             * thrown by a task is rethrown here.
+             */
+            void run(size_t num_tasks, const task_type& task) {
+                if (num_tasks == 0) return;
+
+                bool expected = false;
+                if (num_tasks == 1 || workers_.empty() || !busy_.compare_exchange_strong(expected, true)) {
+                    for (size_t id = 0; id < num_tasks; ++id) task(id);
+                    return;
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    task_ = &task;
+                    num_tasks_ = num_tasks;
+                    next_task_ = 0;
+                    active_workers_ = workers_.size();
+                    error_ = nullptr;
+                    ++generation_;
+                }
+                wake_.notify_all();
+
+                execute();
+
+                std::exception_ptr error;
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    done_.wait(lock, [this] {
+                        return active_workers_ == 0;
+                    });
+                    task_ = nullptr;
+                    error = error_;
+                }
+                busy_ = false;
+
+                if (error) std::rethrow_exception(error);
+            }
+
+        private:
+
+            ThreadPool(size_t num_threads)
+            : task_(nullptr), num_tasks_(0), next_task_(0), active_workers_(0), generation_(0), stop_(false), busy_(false) {
+                for (size_t t = 1; t < num_threads; ++t) {
+                    workers_.push_back(std::thread(&ThreadPool::work, this));
+                }
+            }
+
+            static size_t default_num_threads() {
+                return ThreadBudget::default_threads();
+            }
+
+            /**
+             * Loop of the workers waiting for the jobs
+             */
+            void work() {
+                size_t seen_generation = 0;
+                while (true) {
+                    {
+                        std::unique_lock<std::mutex> lock(mutex_);
+                        wake_.wait(lock, [&] {
+                            return stop_ || generation_ != seen_generation;
+                        });
+                        if (stop_) return;
+                        seen_generation = generation_;
+                    }
+
+                    execute();
+
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (--active_workers_ == 0) done_.notify_all();
+                }
+            }
+
+            /**
+             * Executes the tasks of the current job until none is left
+             */
+            void execute() {
+                size_t id;
+                while ((id = next_task_++) < num_tasks_) {
+                    try {
+                        (*task_)(id);
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        if (!error_) error_ = std::current_exception();
+                    }
+                }
+            }
+
+            std::vector<std::thread> workers_;
+            std::mutex mutex_;
+            std::condition_variable wake_;
+            std::condition_variable done_;
+
+            const task_type* task_;
+            size_t num_tasks_;
+            std::atomic<size_t> next_task_;
+            size_t active_workers_;
+            size_t generation_;
+            bool stop_;
+            std::atomic<bool> busy_;
+            std::exception_ptr error_;
+        };
+
+    }
+}
+
+#endif /* EM_PARALLEL_THREAD_POOL_HPP */
+